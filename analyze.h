@@ -0,0 +1,99 @@
+//
+//  analyze.h
+//  Header file for a one-pass structural summary of an undirected graph
+//
+
+#ifndef analyze_h
+#define analyze_h
+
+#include <vector>
+#include "csr.h"
+#include "cc.h"
+
+// what one traversal of an undirected graph tells about it: the connected
+// components, whether the graph is bipartite, and how its degrees are
+// spread; degrees[d] is the number of vertices of degree d
+struct analysis_result
+{
+    std::size_t n, m;
+    cc_result cc;
+    bool bipartite;
+    bool acyclic;
+    std::size_t odd;                    // vertices of odd degree
+    std::vector<std::size_t> degrees;
+
+    analysis_result(std::size_t nv = 0): n(nv), m(0), cc(nv), bipartite(true),
+        acyclic(true), odd(0)
+    {
+
+    }
+};
+
+
+// breadth-first search from every unvisited vertex of a symmetric csr
+// snapshot, numbering components and 2-coloring by level parity as it goes;
+// an edge inside one color class means an odd cycle
+class analysis_engine
+{
+public:
+
+    // pre: G is symmetric and outlives the engine
+    analysis_engine(const csr_view & G): _G(G), _color(G.n()), _queue(G.n())
+    {
+
+    }
+
+    analysis_result run()
+    {
+        std::size_t n = _G.n();
+        analysis_result ans(n);
+
+        for (vid r = 0; r < n; ++r)
+        {
+            if (ans.cc.comp[r] != NIL)
+                continue;
+
+            vid c = vid(ans.cc.count++);
+            std::size_t head = 0, tail = 0;
+            ans.cc.comp[r] = c;
+            _color[r] = 0;
+            _queue[tail++] = r;
+
+            while (head < tail)
+            {
+                vid v = _queue[head++];
+                std::size_t d = _G.outdeg(v);
+
+                if (d >= ans.degrees.size())
+                    ans.degrees.resize(d + 1, 0);
+                ++ans.degrees[d];
+                ans.odd += d % 2;
+                ans.m += d;
+
+                for (auto w: _G.Adj(v))
+                {
+                    if (ans.cc.comp[w] == NIL)
+                    {
+                        ans.cc.comp[w] = c;
+                        _color[w] = 1 - _color[v];
+                        _queue[tail++] = w;
+                    }
+                    else if (_color[w] == _color[v])
+                        ans.bipartite = false;
+                }
+            }
+        }
+
+        ans.m /= 2;
+        ans.acyclic = (n == ans.m + ans.cc.count);
+        return ans;
+    }
+
+private:
+
+    const csr_view & _G;
+    std::vector<unsigned char> _color;  // bfs level parity
+    std::vector<vid> _queue;
+};
+
+#endif /* analyze_h */
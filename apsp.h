@@ -0,0 +1,129 @@
+//
+//  apsp.h
+//  Header file for all-pairs shortest paths with negative weights
+//  (Johnson's algorithm)
+//
+
+#ifndef apsp_h
+#define apsp_h
+
+#include <vector>
+#include <limits>
+#include <memory>
+#include <algorithm>
+#include <cassert>
+#include "csr.h"
+#include "sssp.h"
+#include "bf.h"
+#include "parallel.h"
+
+// Johnson's algorithm on a weighted csr snapshot whose weights may be
+// negative.  One Bellman-Ford search from an imaginary vertex with an arc
+// of weight 0 to every vertex gives a potential h, and the arc (v, w) is
+// reweighted to w(v, w) + h(v) - h(w), which is never negative.  Dijkstra
+// then runs from every source on the reweighted copy, and the distance
+// d'(s, t) it finds is turned back into d'(s, t) - h(s) + h(t).
+//
+// The engine keeps the reweighted copy and one sssp_engine per worker of
+// the thread pool, so rows of the matrix can be asked for in blocks of
+// sources, and later blocks allocate nothing.
+class johnson_engine
+{
+public:
+
+    // pre: G is weighted and outlives the engine
+    // post: if ok(), potentials are computed and rows() can be called;
+    //       otherwise G has a negative cycle and cycle() is one of them
+    johnson_engine(const csr_view & G): _n(G.n()), _off(G.n() + 1), _adj(G.m()), _w(G.m()),
+        _R(), _q(sssp_engine::HEAP), _E(thread_pool::instance().size())
+    {
+        bf_engine B(G);
+        double weight;
+
+        _ok = !B.negative_cycle(_cycle, weight);
+        if (!_ok)
+            return;
+        _h = B.dists();
+
+        for (vid v = 0; v <= _n; ++v)
+            _off[v] = G.first(v);
+        parallel_for(0, _n, [&](std::size_t v)
+        {
+            for (std::size_t i = G.first(vid(v)); i < G.first(vid(v+1)); ++i)
+            {
+                _adj[i] = G.target(i);
+                _w[i] = std::max(0.0, G.cost(i) + _h[v] - _h[_adj[i]]);   // rounding may go below 0
+            }
+        }, 256);
+
+        _R = csr_view(_n, _off.data(), _adj.data(), _w.data());
+        _q = sssp_engine::choose(_R);
+    }
+
+    johnson_engine(const johnson_engine &) = delete;
+    johnson_engine & operator = (const johnson_engine &) = delete;
+
+    // post: returns false iff G has a negative cycle
+    bool ok() const
+    {
+        return _ok;
+    }
+
+    // post: returns the negative cycle found, if !ok(), in the form of
+    //       bf_engine::negative_cycle
+    const std::vector<vid> & cycle() const
+    {
+        return _cycle;
+    }
+
+    // pre: ok()
+    // post: returns the potential of every vertex
+    const std::vector<double> & potentials() const
+    {
+        return _h;
+    }
+
+    // pre: ok(), b <= e <= G.n() and out has room for (e - b) * G.n() values
+    // post: out[(s - b) * G.n() + t] is the distance from s to t, or
+    //       infinity if there is none, for every b <= s < e.  Sources are
+    //       spread over the workers of the thread pool.
+    void rows(vid b, vid e, double * out)
+    {
+        assert(_ok && b <= e && e <= _n);
+
+        parallel_for_workers(b, e, [&](std::size_t s, std::size_t t)
+        {
+            if (!_E[t])
+                _E[t].reset(new sssp_engine(_R, _q));
+            _E[t]->run(vid(s));
+
+            double * row = out + (s - b) * _n;
+            std::fill(row, row + _n, std::numeric_limits<double>::infinity());
+            for (auto v: _E[t]->touched())
+                row[v] = _E[t]->dist(v) - _h[s] + _h[v];
+        }, 1);
+    }
+
+    // pre: ok() and out has room for G.n() * G.n() values
+    // post: out[s * G.n() + t] is the distance from s to t, or infinity if
+    //       there is none
+    void run(double * out)
+    {
+        rows(0, vid(_n), out);
+    }
+
+private:
+
+    std::size_t _n;
+    bool _ok;
+    std::vector<vid> _cycle;            // a negative cycle, if !_ok
+    std::vector<double> _h;             // potentials
+    std::vector<std::size_t> _off;      // the reweighted copy of G
+    std::vector<vid> _adj;
+    std::vector<double> _w;
+    csr_view _R;
+    sssp_engine::fringe _q;
+    std::vector<std::unique_ptr<sssp_engine>> _E;   // one per worker, made on first use
+};
+
+#endif /* apsp_h */
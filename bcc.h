@@ -0,0 +1,148 @@
+//
+//  bcc.h
+//  Header file for articulation points, bridges and biconnected components
+//
+
+#ifndef bcc_h
+#define bcc_h
+
+#include <vector>
+#include <utility>
+#include <cassert>
+#include "csr.h"
+
+// articulation points and bridges of an undirected graph, and the
+// biconnected component of each arc: arc i lies in component comp[i],
+// components are 0, ..., count-1, and both arcs of an edge share one
+struct bcc_result
+{
+    std::vector<vid> articulation;
+    std::vector<std::pair<vid, vid>> bridges;
+    std::vector<vid> comp;
+    std::size_t count;
+
+    bcc_result(): count(0)
+    {
+
+    }
+};
+
+
+// Hopcroft-Tarjan on a symmetric csr snapshot (every edge stored as two
+// arcs, no loops or parallel edges) with an explicit call stack, so the
+// depth of the dfs tree does not matter.  All scratch space is allocated
+// once, when the engine is made.
+//
+// Components are found per vertex: the component of edge {x, y}, where y
+// was discovered after x, is the component of the tree edge into y, so it
+// is enough to name the tree edge into every non-root vertex.
+class bcc_engine
+{
+public:
+
+    // pre: G is symmetric and outlives the engine
+    bcc_engine(const csr_view & G): _G(G), _pre(G.n()), _low(G.n()), _parent(G.n()),
+        _name(G.n()), _cursor(G.n()), _call(G.n()), _stack(G.n())
+    {
+
+    }
+
+    bcc_result run()
+    {
+        std::size_t n = _G.n();
+        bcc_result ans;
+        vid time = 0;
+
+        std::fill(_pre.begin(), _pre.end(), NIL);
+        std::fill(_name.begin(), _name.end(), NIL);
+
+        for (vid r = 0; r < n; ++r)
+        {
+            if (_pre[r] != NIL)
+                continue;
+
+            std::size_t top = 0, sp = 0, children = 0;  // call stack and vertex stack sizes
+            _visit(r, r, time, top, sp);
+
+            while (top > 0)
+            {
+                vid v = _call[top-1];
+                std::size_t & i = _cursor[v];
+
+                if (i < _G.first(v+1))
+                {
+                    vid w = _G.target(i++);
+                    if (_pre[w] == NIL)        // tree edge
+                    {
+                        if (v == r)
+                            ++children;
+                        _visit(w, v, time, top, sp);
+                    }
+                    else if (w != _parent[v])  // back edge
+                        _low[v] = std::min(_low[v], _pre[w]);
+                    continue;
+                }
+
+                // v is finished; report to its parent u
+                --top;
+                if (v == r)
+                    break;
+                vid u = _parent[v];
+                _low[u] = std::min(_low[u], _low[v]);
+
+                if (_low[v] >= _pre[u])      // u separates v's subtree
+                {
+                    if (u != r && (ans.articulation.empty() || ans.articulation.back() != u))
+                        ans.articulation.push_back(u);
+                    if (_low[v] > _pre[u])
+                        ans.bridges.push_back({u, v});
+
+                    vid x;
+                    do
+                    {
+                        x = _stack[--sp];
+                        _name[x] = vid(ans.count);
+                    } while (x != v);
+                    ++ans.count;
+                }
+            }
+
+            if (children >= 2)
+                ans.articulation.push_back(r);
+        }
+
+        // an articulation point can be reported after each of its children
+        std::sort(ans.articulation.begin(), ans.articulation.end());
+        ans.articulation.erase(std::unique(ans.articulation.begin(), ans.articulation.end()),
+                               ans.articulation.end());
+
+        ans.comp.resize(_G.m());
+        for (vid v = 0; v < n; ++v)
+            for (std::size_t i = _G.first(v); i < _G.first(v+1); ++i)
+            {
+                vid w = _G.target(i);
+                ans.comp[i] = _name[_pre[v] > _pre[w] ? v : w];
+            }
+        return ans;
+    }
+
+private:
+
+    const csr_view & _G;
+    std::vector<vid> _pre, _low, _parent, _name;
+    std::vector<std::size_t> _cursor;   // next arc to scan, per vertex
+    std::vector<vid> _call;             // dfs path from the root
+    std::vector<vid> _stack;            // discovered vertices not yet in a component
+
+    void _visit(vid v, vid parent, vid & time, std::size_t & top, std::size_t & sp)
+    {
+        _pre[v] = _low[v] = time++;
+        _parent[v] = parent;
+        _cursor[v] = _G.first(v);
+        _call[top++] = v;
+        if (v != parent)
+            _stack[sp++] = v;
+    }
+};
+
+#endif /* bcc_h */
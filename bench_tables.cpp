@@ -0,0 +1,82 @@
+//
+//  bench_tables.cpp
+//  This file times the flat hash tables against the std ones: building a
+//  network, looking up edge costs, and inserting into and searching a map
+//
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "wedge.h"
+#include "network.h"
+#include "flat_hash.h"
+
+using namespace std;
+
+// post: returns the seconds elapsed since t, and sets t to now
+double lap(chrono::steady_clock::time_point & t)
+{
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    double ans = chrono::duration<double>(now - t).count();
+    t = now;
+    return ans;
+}
+
+//pre: Tables is flat_tables or std_tables
+//post: prints the times of each case on a random network of n vertices
+//      and m edges, and on m random keys; every run uses the same input
+template <class Tables>
+void run(const string & name, int n, int m)
+{
+    mt19937 rng(7);
+    vector<WEdge<int>> e;
+    e.reserve(m);
+    for (int i = 0; i < m; i++)
+        e.push_back(WEdge<int>(rng() % n, rng() % n, rng() % 100));
+
+    chrono::steady_clock::time_point t = chrono::steady_clock::now();
+
+    //build: one vertex at a time, then one edge at a time
+    network<int, Tables> net;
+    for (int i = 0; i < n; i++)
+        net.add_vertex(i);
+    for (auto & x: e)
+        net.add_edge(x.s, x.d, x.w);
+    double build = lap(t);
+
+    //cost(): every edge looked up three times
+    double sum = 0;
+    for (int r = 0; r < 3; r++)
+        for (auto & x: e)
+            sum += net.cost(x.s, x.d);
+    double cost = lap(t);
+
+    //map insert and lookup of random int keys
+    typename Tables::template map<int, int> M;
+    for (int i = 0; i < m; i++)
+        M[rng()] = i;
+    double insert = lap(t);
+
+    long found = 0;
+    for (int i = 0; i < m; i++)
+        found += M.count(rng());
+    double lookup = lap(t);
+
+    cout << name << ": build " << build << "s, cost() x3 " << cost << "s, map insert "
+         << insert << "s, map lookup " << lookup << "s (" << sum << ", " << found << ")" << endl;
+}
+
+//usage: bench_tables [std]; times flat_tables, or std_tables if given "std".
+//       Run each in its own process so their peak memory can be compared.
+int main(int argc, char ** argv)
+{
+    const int n = 200000, m = 2000000;
+
+    if (argc > 1 && string(argv[1]) == "std")
+        run<std_tables>("std", n, m);
+    else
+        run<flat_tables>("flat", n, m);
+    return 0;
+}
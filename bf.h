@@ -0,0 +1,377 @@
+//
+//  bf.h
+//  Header file for single-source shortest paths with negative weights
+//  (Bellman-Ford)
+//
+
+#ifndef bf_h
+#define bf_h
+
+#include <vector>
+#include <limits>
+#include <atomic>
+#include <cassert>
+#include <algorithm>
+#include "csr.h"
+#include "parallel.h"
+
+// Bellman-Ford on a weighted csr snapshot.  The arcs are copied once into
+// a flat array of (tail, head, weight) records grouped by head, so a round
+// is one pass over contiguous memory with no lookups.  Three ways to run:
+//
+//     rounds()    relaxes every arc in place, round after round, and stops
+//                 after the first round that changes nothing
+//     spfa()      keeps a FIFO queue of vertices whose distance dropped and
+//                 only relaxes their arcs
+//     parallel()  rounds in which every head pulls from its in-arcs, reading
+//                 the distances of the previous round, so threads need no
+//                 locks; the two distance arrays are swapped, never copied
+//
+// Each returns false iff it found a negative cycle reachable from s, in
+// which case the distances are not meaningful.  negative_cycle() also
+// returns the cycle itself, as soon as it forms (see below).
+class bf_engine
+{
+public:
+
+    struct arc
+    {
+        vid s, d;
+        double w;
+    };
+
+    // pre: G is weighted and outlives the engine
+    // post: the arcs grouped by head, which only rounds() and parallel()
+    //       read, are copied out of G on the first call of either
+    bf_engine(const csr_view & G): _G(G), _n(G.n()), _dist(G.n()), _parent(G.n()), _rounds(0)
+    {
+
+    }
+
+    // pre: s < G.n()
+    bool rounds(vid s)
+    {
+        _by_head();
+        _start(s);
+        for (_rounds = 1; _rounds <= _n; ++_rounds)
+        {
+            bool changed = false;
+            for (auto & a: _arcs)
+            {
+                double temp = _dist[a.s] + a.w;
+                if (temp < _dist[a.d])  // found better route
+                {
+                    _dist[a.d] = temp;
+                    _parent[a.d] = a.s;
+                    changed = true;
+                }
+            }
+            if (!changed)
+                return true;
+        }
+        return false;   // still changing after n rounds
+    }
+
+    // pre: s < G.n()
+    // post: a vertex whose path from s grows to n arcs is on or behind a
+    //       negative cycle, so the search stops there
+    bool spfa(vid s)
+    {
+        std::vector<vid> Q(_n);             // circular queue; a vertex is in it at most once
+        std::vector<unsigned char> queued(_n, 0);
+        std::vector<std::size_t> len(_n, 0);   // arcs on the path found to each vertex
+        std::size_t head = 0, size = 0;
+
+        _start(s);
+        Q[0] = s;
+        queued[s] = 1;
+        size = 1;
+        _rounds = 0;
+
+        while (size > 0)
+        {
+            vid v = Q[head];
+            head = (head + 1) % _n;
+            --size;
+            queued[v] = 0;
+            ++_rounds;
+
+            for (std::size_t i = _G.first(v); i < _G.first(v+1); ++i)
+            {
+                vid w = _G.target(i);
+                double temp = _dist[v] + _G.cost(i);
+                if (temp < _dist[w])    // found better route
+                {
+                    _dist[w] = temp;
+                    _parent[w] = v;
+                    len[w] = len[v] + 1;
+                    if (len[w] >= _n)
+                        return false;
+                    if (!queued[w])
+                    {
+                        Q[(head + size) % _n] = w;
+                        queued[w] = 1;
+                        ++size;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    // pre: s < G.n()
+    // post: parents are those of some shortest path tree, not necessarily
+    //       the one rounds() finds
+    bool parallel(vid s)
+    {
+        _by_head();
+        std::vector<double> next(_n);
+        std::vector<vid> from(_n);
+
+        _start(s);
+        for (_rounds = 1; _rounds <= _n; ++_rounds)
+        {
+            std::atomic<bool> changed(false);
+            parallel_for(0, _n, [&](std::size_t v)
+            {
+                double best = _dist[v];
+                vid p = _parent[v];
+                for (std::size_t i = _in_off[v]; i < _in_off[v+1]; ++i)
+                {
+                    double temp = _dist[_arcs[i].s] + _arcs[i].w;
+                    if (temp < best)
+                    {
+                        best = temp;
+                        p = _arcs[i].s;
+                    }
+                }
+                if (best < _dist[v])
+                    changed.store(true, std::memory_order_relaxed);
+                next[v] = best;
+                from[v] = p;
+            }, 4096);
+
+            _dist.swap(next);
+            _parent.swap(from);
+            if (!changed)
+                return true;
+        }
+        return false;
+    }
+
+    // pre: s < G.n()
+    // post: returns true iff a negative cycle is reachable from s; cycle
+    //       then lists its vertices in order (an arc from the last back to
+    //       the first closes it) and weight is its total weight.  Otherwise
+    //       dist() and parent() hold shortest paths from s.
+    //
+    // This is the queue-based search with Tarjan's subtree disassembly: the
+    // shortest path tree is kept as a preorder list with depths, and when
+    // the distance of w drops through an arc (v, w), the subtree of w is
+    // cut out of the tree, since every distance in it is now too large.
+    // If v is in that subtree, the tree path from w to v and the arc (v, w)
+    // form a negative cycle, which is caught the moment it closes.
+    // Vertices cut out are skipped when they reach the front of the queue.
+    bool negative_cycle(vid s, std::vector<vid> & cycle, double & weight)
+    {
+        assert(s < _n);
+        _start(s);
+        return _disassemble(std::vector<vid>(1, s), cycle, weight);
+    }
+
+    // post: same, for negative cycles anywhere in G, by a search from an
+    //       imaginary vertex with an arc of weight 0 to every vertex
+    bool negative_cycle(std::vector<vid> & cycle, double & weight)
+    {
+        std::vector<vid> all(_n);
+        for (vid v = 0; v < _n; ++v)
+        {
+            all[v] = v;
+            _dist[v] = 0;
+            _parent[v] = v;
+        }
+        return _disassemble(all, cycle, weight);
+    }
+
+    // pre: s < G.n()
+    // post: runs parallel() if the graph is large enough to gain from it and
+    //       there is more than one thread, and spfa() otherwise
+    bool run(vid s)
+    {
+        if (thread_pool::instance().size() > 1 && _G.m() >= PARALLEL_ARCS)
+            return parallel(s);
+        return spfa(s);
+    }
+
+    static constexpr std::size_t PARALLEL_ARCS = 1 << 20;
+
+    double dist(vid v) const
+    {
+        return _dist[v];
+    }
+
+    // post: returns the vertex before v on the path found to v; the source
+    //       is its own parent unless it lies on a negative cycle, and
+    //       unreached vertices have parent NIL
+    vid parent(vid v) const
+    {
+        return _parent[v];
+    }
+
+    const std::vector<double> & dists() const
+    {
+        return _dist;
+    }
+
+    const std::vector<vid> & parents() const
+    {
+        return _parent;
+    }
+
+    // post: returns the rounds made by the last rounds() or parallel(), or
+    //       the vertices taken off the queue by the last spfa()
+    std::size_t work() const
+    {
+        return _rounds;
+    }
+
+    // post: returns the arcs, grouped by head
+    const std::vector<arc> & arcs()
+    {
+        _by_head();
+        return _arcs;
+    }
+
+private:
+
+    const csr_view & _G;
+    std::size_t _n;
+    std::vector<std::size_t> _in_off;   // in-arcs of v are _arcs[_in_off[v], _in_off[v+1])
+    std::vector<arc> _arcs;             // empty until _by_head()
+    std::vector<double> _dist;
+    std::vector<vid> _parent;
+    std::size_t _rounds;
+
+    // post: _in_off and _arcs hold the arcs of G grouped by head
+    void _by_head()
+    {
+        if (!_in_off.empty())
+            return;
+
+        _in_off.assign(_n + 1, 0);
+        _arcs.resize(_G.m());
+        for (std::size_t i = 0; i < _G.m(); ++i)
+            ++_in_off[_G.target(i) + 1];
+        for (vid v = 0; v < _n; ++v)
+            _in_off[v+1] += _in_off[v];
+
+        std::vector<std::size_t> next(_in_off.begin(), _in_off.end() - 1);
+        for (vid v = 0; v < _n; ++v)
+            for (std::size_t i = _G.first(v); i < _G.first(v+1); ++i)
+                _arcs[next[_G.target(i)]++] = {v, _G.target(i), _G.cost(i)};
+    }
+
+    // pre: the roots have distances set and are their own parents
+    bool _disassemble(const std::vector<vid> & roots, std::vector<vid> & cycle, double & weight)
+    {
+        std::vector<vid> next(_n, NIL), prev(_n, NIL);     // preorder list of the tree
+        std::vector<std::size_t> depth(_n, 0);
+        std::vector<std::size_t> via(_n);                   // arc from the parent
+        std::vector<unsigned char> intree(_n, 0), queued(_n, 0);
+        std::vector<vid> Q(_n);
+        std::size_t head = 0, size = 0;
+
+        // the roots form a forest of one-vertex trees, listed in a row
+        for (std::size_t k = 0; k < roots.size(); ++k)
+        {
+            vid r = roots[k];
+            intree[r] = queued[r] = 1;
+            Q[size++] = r;
+            if (k > 0)
+            {
+                next[roots[k-1]] = r;
+                prev[r] = roots[k-1];
+            }
+        }
+
+        cycle.clear();
+        weight = 0;
+        _rounds = 0;
+
+        while (size > 0)
+        {
+            vid v = Q[head];
+            head = (head + 1) % _n;
+            --size;
+            queued[v] = 0;
+            if (!intree[v])     // cut out since it was queued
+                continue;
+            ++_rounds;
+
+            for (std::size_t i = _G.first(v); i < _G.first(v+1); ++i)
+            {
+                vid w = _G.target(i);
+                double temp = _dist[v] + _G.cost(i);
+                if (!(temp < _dist[w]))
+                    continue;
+
+                if (intree[w])
+                {
+                    // cut out the subtree of w; meeting v in it closes a cycle
+                    vid x = (w == v) ? v : next[w];
+                    for (; x != NIL && (x == w || depth[x] > depth[w]); x = next[x])
+                    {
+                        if (x == v)
+                        {
+                            for (vid y = v; y != w; y = _parent[y])
+                            {
+                                cycle.push_back(y);
+                                weight += _G.cost(via[y]);
+                            }
+                            cycle.push_back(w);
+                            weight += _G.cost(i);
+                            std::reverse(cycle.begin(), cycle.end());
+                            return true;
+                        }
+                        intree[x] = 0;
+                    }
+                    if (prev[w] != NIL)
+                        next[prev[w]] = x;
+                    if (x != NIL)
+                        prev[x] = prev[w];
+                }
+
+                // w becomes the first child of v
+                _dist[w] = temp;
+                _parent[w] = v;
+                via[w] = i;
+                depth[w] = depth[v] + 1;
+                intree[w] = 1;
+                next[w] = next[v];
+                prev[w] = v;
+                if (next[v] != NIL)
+                    prev[next[v]] = w;
+                next[v] = w;
+
+                if (!queued[w])
+                {
+                    Q[(head + size) % _n] = w;
+                    queued[w] = 1;
+                    ++size;
+                }
+            }
+        }
+        return false;
+    }
+
+    void _start(vid s)
+    {
+        assert(s < _n);
+        std::fill(_dist.begin(), _dist.end(), std::numeric_limits<double>::infinity());
+        std::fill(_parent.begin(), _parent.end(), NIL);
+        _dist[s] = 0;
+        _parent[s] = s;
+    }
+};
+
+#endif /* bf_h */
@@ -0,0 +1,255 @@
+//
+//  bfs.h
+//  Header file for a direction-optimizing parallel breadth-first search
+//
+
+#ifndef bfs_h
+#define bfs_h
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cassert>
+#include "csr.h"
+#include "parallel.h"
+
+// Beamer-style BFS over a csr snapshot: levels with few frontier arcs are
+// expanded top-down from a frontier queue, levels with many are expanded
+// bottom-up by letting every unvisited vertex look for a parent in a
+// frontier bitmap.  Bottom-up steps need the in-neighbors of each vertex,
+// so the engine takes the reverse digraph R as well (for an undirected
+// graph stored with both arcs, R is the graph itself).
+//
+// Vertices stay visited across calls to run(), so repeated runs from every
+// unvisited vertex label all components in O(n + m) total.
+class bfs_engine
+{
+public:
+
+    // pre: R is the reverse of G (or G itself if G is symmetric); both
+    //      outlive the engine
+    bfs_engine(const csr_view & G, const csr_view & R):
+        _G(G), _R(R), _parent(new std::atomic<vid>[G.n()]), _level(G.n(), NIL),
+        _front((G.n() + 63) / 64), _next((G.n() + 63) / 64), _unexplored(G.m())
+    {
+        assert(G.n() == R.n() && G.m() == R.m());
+        for (vid v = 0; v < G.n(); ++v)
+            _parent[v].store(NIL, std::memory_order_relaxed);
+    }
+
+    // pre: none
+    // post: every vertex is unvisited again
+    void reset()
+    {
+        for (vid v = 0; v < _G.n(); ++v)
+            _parent[v].store(NIL, std::memory_order_relaxed);
+        std::fill(_level.begin(), _level.end(), NIL);
+        _unexplored = _G.m();
+    }
+
+    bool visited(vid v) const
+    {
+        return (_parent[v].load(std::memory_order_relaxed) != NIL);
+    }
+
+    // pre: v was reached by some run
+    // post: returns the bfs parent of v; a start vertex is its own parent
+    vid parent(vid v) const
+    {
+        return _parent[v].load(std::memory_order_relaxed);
+    }
+
+    // post: returns the distance from the start vertex of v's run to v,
+    //       or NIL if v has not been reached
+    vid level(vid v) const
+    {
+        return _level[v];
+    }
+
+    // post: returns the vertices reached by the last run, level by level
+    const std::vector<vid> & order() const
+    {
+        return _order;
+    }
+
+    // post: returns the dense parent array (NIL for unreached vertices)
+    std::vector<vid> parents() const
+    {
+        std::vector<vid> ans(_G.n());
+        for (vid v = 0; v < _G.n(); ++v)
+            ans[v] = parent(v);
+        return ans;
+    }
+
+    const std::vector<vid> & levels() const
+    {
+        return _level;
+    }
+
+    // pre: s < n() and s is unvisited
+    // post: every unvisited vertex reachable from s has been visited and
+    //       given a parent and a level
+    void run(vid s)
+    {
+        assert(s < _G.n() && !visited(s));
+
+        _order.clear();
+        _parent[s].store(s, std::memory_order_relaxed);
+        _level[s] = 0;
+        _order.push_back(s);
+        _unexplored -= _G.outdeg(s);
+
+        std::size_t head = 0;          // _order[head..] is the current frontier
+        std::size_t frontier_arcs = _G.outdeg(s);
+        bool bottom_up = false;
+
+        for (vid depth = 1; head < _order.size(); ++depth)
+        {
+            std::size_t frontier = _order.size() - head;
+
+            if (!bottom_up && frontier_arcs > _unexplored / ALPHA)
+                bottom_up = true;
+            else if (bottom_up && frontier < _G.n() / BETA)
+                bottom_up = false;
+
+            std::size_t tail = _order.size();
+            if (bottom_up)
+                frontier_arcs = _bottom_up(head, tail, depth);
+            else
+                frontier_arcs = _top_down(head, tail, depth);
+            head = tail;
+        }
+    }
+
+private:
+
+    static const std::size_t ALPHA = 14;    // top-down -> bottom-up threshold
+    static const std::size_t BETA = 24;     // bottom-up -> top-down threshold
+
+    const csr_view & _G, & _R;
+    std::unique_ptr<std::atomic<vid>[]> _parent;
+    std::vector<vid> _level;
+    std::vector<std::uint64_t> _front;              // frontier bitmap
+    std::vector<std::atomic<std::uint64_t>> _next;  // next frontier bitmap
+    std::size_t _unexplored;                        // arcs leaving unvisited vertices
+    std::vector<vid> _order;                        // vertices of this run in bfs order
+
+    // post: expands _order[head..tail) into the next level, appends it to
+    //       _order and returns the number of arcs leaving it
+    std::size_t _top_down(std::size_t head, std::size_t tail, vid depth)
+    {
+        std::size_t workers = thread_pool::instance().size();
+        std::vector<std::vector<vid>> local(workers);
+        std::atomic<std::size_t> next(head), arcs(0);
+        const std::size_t grain = 64;
+
+        auto step = [&](std::size_t t)
+        {
+            std::size_t my_arcs = 0;
+            for (;;)
+            {
+                std::size_t lo = next.fetch_add(grain);
+                if (lo >= tail)
+                    break;
+                std::size_t hi = std::min(tail, lo + grain);
+                for (std::size_t k = lo; k < hi; ++k)
+                {
+                    vid v = _order[k];
+                    for (auto w: _G.Adj(v))
+                    {
+                        vid none = NIL;
+                        if (_parent[w].load(std::memory_order_relaxed) == NIL &&
+                            _parent[w].compare_exchange_strong(none, v, std::memory_order_relaxed))
+                        {
+                            _level[w] = depth;
+                            local[t].push_back(w);
+                            my_arcs += _G.outdeg(w);
+                        }
+                    }
+                }
+            }
+            arcs += my_arcs;
+        };
+
+        if (tail - head <= grain || workers == 1)
+            for (std::size_t t = 0; t < workers; ++t)
+                step(t);
+        else
+            thread_pool::instance().run(step);
+
+        for (auto & l: local)
+            _order.insert(_order.end(), l.begin(), l.end());
+        _unexplored -= arcs;
+        return arcs;
+    }
+
+    // post: same as _top_down, but every unvisited vertex searches its
+    //       in-neighbors for a member of the frontier
+    std::size_t _bottom_up(std::size_t head, std::size_t tail, vid depth)
+    {
+        std::fill(_front.begin(), _front.end(), 0);
+        for (std::size_t k = head; k < tail; ++k)
+            _front[_order[k] / 64] |= std::uint64_t(1) << (_order[k] % 64);
+
+        std::atomic<std::size_t> arcs(0);
+
+        // each block of 64 vertices is handled by one thread, so every
+        // word of _next has a single writer
+        parallel_for(0, _next.size(), [&](std::size_t b)
+        {
+            std::uint64_t found = 0;
+            std::size_t my_arcs = 0;
+            vid hi = vid(std::min<std::size_t>(_G.n(), (b + 1) * 64));
+            for (vid v = vid(b * 64); v < hi; ++v)
+            {
+                if (_parent[v].load(std::memory_order_relaxed) != NIL)
+                    continue;
+                for (auto u: _R.Adj(v))
+                {
+                    if (_front[u / 64] & (std::uint64_t(1) << (u % 64)))
+                    {
+                        _parent[v].store(u, std::memory_order_relaxed);
+                        _level[v] = depth;
+                        found |= std::uint64_t(1) << (v % 64);
+                        my_arcs += _G.outdeg(v);
+                        break;
+                    }
+                }
+            }
+            _next[b].store(found, std::memory_order_relaxed);
+            if (my_arcs != 0)
+                arcs += my_arcs;
+        }, 16);
+
+        for (std::size_t b = 0; b < _next.size(); ++b)
+        {
+            std::uint64_t word = _next[b].load(std::memory_order_relaxed);
+            while (word != 0)
+            {
+                int i = __builtin_ctzll(word);
+                _order.push_back(vid(b * 64 + i));
+                word &= word - 1;
+            }
+        }
+        _unexplored -= arcs;
+        return arcs;
+    }
+};
+
+
+// pre: R is the reverse of G (or G itself if G is symmetric) and s < G.n()
+// post: parent[v] is the bfs parent of v (parent[s] = s, NIL if v is not
+//       reachable from s) and level[v] is the distance from s to v (NIL if
+//       not reachable)
+inline void bfs(const csr_view & G, const csr_view & R, vid s,
+                std::vector<vid> & parent,
+                std::vector<vid> & level)
+{
+    bfs_engine E(G, R);
+    E.run(s);
+    parent = E.parents();
+    level = E.levels();
+}
+
+#endif /* bfs_h */
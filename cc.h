@@ -0,0 +1,113 @@
+//
+//  cc.h
+//  Header file for parallel connected components by union-find hooking
+//
+
+#ifndef cc_h
+#define cc_h
+
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include "csr.h"
+#include "parallel.h"
+#include "ds.h"
+
+// comp[v] is the component of vertex v; components are 0, ..., count-1
+struct cc_result
+{
+    std::vector<vid> comp;
+    std::size_t count;
+
+    cc_result(std::size_t n = 0): comp(n, NIL), count(0)
+    {
+
+    }
+};
+
+
+// connected components of a symmetric csr snapshot (every edge stored as
+// two arcs) with the Afforest scheme: all threads join the endpoints of
+// arcs in one concurrent_ds.  Joining a couple of arcs per vertex first
+// usually builds the giant component, whose vertices can then skip the
+// rest of their arcs.
+class cc_engine
+{
+public:
+
+    // pre: G is symmetric and outlives the engine
+    cc_engine(const csr_view & G): _G(G), _S(G.n())
+    {
+
+    }
+
+    // post: returns the components of G
+    cc_result run(std::size_t rounds = 2)
+    {
+        std::size_t n = _G.n();
+        cc_result ans(n);
+        if (n == 0)
+            return ans;
+
+        // join the first few arcs of every vertex
+        for (std::size_t r = 0; r < rounds; ++r)
+            parallel_for(0, n, [&](std::size_t v)
+            {
+                if (r < _G.outdeg(vid(v)))
+                    _S.join(vid(v), _G.target(_G.first(vid(v)) + r));
+            });
+
+        // the vertices of the largest set so far need no more work
+        vid big = _sample();
+        parallel_for(0, n, [&](std::size_t v)
+        {
+            if (_S.find(vid(v)) == big)
+                return;
+            for (std::size_t i = _G.first(vid(v)) + rounds; i < _G.first(vid(v)+1); ++i)
+                _S.join(vid(v), _G.target(i));
+        }, 256);
+
+        // number the roots 0, 1, ...
+        std::vector<vid> root(n), name(n, NIL);
+        parallel_for(0, n, [&](std::size_t v)
+        {
+            root[v] = _S.find(vid(v));
+        });
+        for (vid v = 0; v < n; ++v)
+            if (root[v] == v)
+                name[v] = vid(ans.count++);
+        parallel_for(0, n, [&](std::size_t v)
+        {
+            ans.comp[v] = name[root[v]];
+        });
+        return ans;
+    }
+
+private:
+
+    const csr_view & _G;
+    concurrent_ds _S;           // one set per component found so far
+
+    // post: returns the most frequent root among a sample of vertices
+    vid _sample(std::size_t k = 1024)
+    {
+        std::mt19937 gen(27491);
+        std::uniform_int_distribution<vid> pick(0, vid(_G.n() - 1));
+        std::unordered_map<vid, std::size_t> count;
+        vid best = 0;
+        std::size_t most = 0;
+
+        for (std::size_t i = 0; i < k; ++i)
+        {
+            vid r = _S.find(pick(gen));
+            if (++count[r] > most)
+            {
+                most = count[r];
+                best = r;
+            }
+        }
+        return best;
+    }
+};
+
+#endif /* cc_h */
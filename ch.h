@@ -0,0 +1,761 @@
+//
+//  ch.h
+//  Header file for contraction hierarchies: preprocessing of a static
+//  network for fast repeated shortest path queries
+//
+
+#ifndef ch_h
+#define ch_h
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+#include <memory>
+#include <atomic>
+#include "csr.h"
+#include "view.h"
+#include "dary_heap.h"
+#include "parallel.h"
+
+// A contraction hierarchy removes the vertices of a network one by one, in
+// order of rank; removing v adds a shortcut (u, w) for every path u -> v -> w
+// that is the only shortest path between its ends among the vertices left,
+// so distances among those stay the same.  Every arc of the network or a
+// shortcut then leads up or down in rank, and a shortest s-t path goes up
+// from s and then down to t, which a bidirectional search that only moves
+// up in rank finds while settling a tiny part of the graph.
+//
+// The arcs are kept in two csr arrays of 16-byte records: up(v) holds the
+// arcs (v, w) with rank[w] > rank[v], and down(v) the arcs (u, v) with
+// rank[u] > rank[v], stored under v with target u.  A shortcut remembers the
+// vertex it skips, so paths can be unpacked.
+class contraction_hierarchy
+{
+public:
+
+    struct arc
+    {
+        vid target;
+        vid mid;        // vertex the shortcut skips, or NIL for an arc of the network
+        double w;
+    };
+
+    static constexpr std::size_t WITNESS_LIMIT = 1000;     // vertices a witness search may settle
+
+    contraction_hierarchy(): _n(0), _m(0), _fingerprint(0)
+    {
+        _up_off.assign(1, 0);
+        _down_off.assign(1, 0);
+    }
+
+    // pre: G is weighted, has no negative weights
+    // post: builds the hierarchy of G, with the same vertex ids; see build()
+    contraction_hierarchy(const csr_view & G): contraction_hierarchy()
+    {
+        build(G);
+    }
+
+    std::size_t n() const
+    {
+        return _n;
+    }
+
+    // post: returns the number of arcs, shortcuts included
+    std::size_t m() const
+    {
+        return _up.size() + _down.size();
+    }
+
+    // pre: v < n()
+    vid rank(vid v) const
+    {
+        return _rank[v];
+    }
+
+    range<const arc *> up(vid v) const
+    {
+        return range<const arc *>(_up.data() + _up_off[v], _up.data() + _up_off[v+1]);
+    }
+
+    range<const arc *> down(vid v) const
+    {
+        return range<const arc *>(_down.data() + _down_off[v], _down.data() + _down_off[v+1]);
+    }
+
+    // pre: G is weighted and has no negative weights
+    // post: this is the hierarchy of G.  Vertices are contracted in rounds:
+    //       each round takes every vertex whose priority (the shortcuts it
+    //       would add, less the arcs it would remove, plus its contracted
+    //       neighbors) is smaller than that of all its neighbors, and all
+    //       threads contract these independent vertices at once.  Witness
+    //       searches skip the vertices of the round, so two of them never
+    //       both rely on a path through the other.
+    void build(const csr_view & G)
+    {
+        _builder B(G);
+        B.run(*this);
+        _m = G.m();
+        _fingerprint = fingerprint(G);
+    }
+
+    // pre: G is weighted
+    // post: returns a 64-bit hash of the arcs of G and their weights, by
+    //       id; a hierarchy is only opened against a network with the same
+    //       n, m and fingerprint as the one it was built from
+    static std::uint64_t fingerprint(const csr_view & G)
+    {
+        const std::uint64_t prime = 1099511628211ull;
+        std::vector<std::uint64_t> h(G.n());
+
+        parallel_for(0, G.n(), [&](std::size_t v)
+        {
+            std::uint64_t x = 14695981039346656037ull;
+            for (std::size_t i = G.first(vid(v)); i < G.first(vid(v+1)); ++i)
+            {
+                std::uint64_t w;
+                double c = G.cost(i);
+                std::memcpy(&w, &c, sizeof(w));
+                x = (x ^ G.target(i)) * prime;
+                x = (x ^ w) * prime;
+            }
+            h[v] = x;
+        }, 256);
+
+        std::uint64_t ans = 14695981039346656037ull;
+        for (auto x: h)
+            ans = (ans ^ x) * prime;
+        return ans;
+    }
+
+    // post: returns true iff G has the n, m and fingerprint of the network
+    //       this hierarchy was built from
+    bool matches(const csr_view & G) const
+    {
+        return G.n() == _n && G.m() == _m && fingerprint(G) == _fingerprint;
+    }
+
+    // post: returns true iff this hierarchy was written to the file at path
+    bool save(const std::string & path) const
+    {
+        header h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, MAGIC, sizeof(h.magic));
+        h.version = VERSION;
+        h.n = _n;
+        h.up = _up.size();
+        h.down = _down.size();
+        h.m = _m;
+        h.fingerprint = _fingerprint;
+
+        std::FILE * f = std::fopen(path.c_str(), "wb");
+        if (f == nullptr)
+            return false;
+        bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+                  _write(f, _rank) && _write(f, _up_off) && _write(f, _down_off) &&
+                  _write(f, _up) && _write(f, _down);
+        return (std::fclose(f) == 0 && ok);
+    }
+
+    // pre: G is the network the hierarchy is meant for, numbered as when
+    //      it was built (e.g. the same network's frozen())
+    // post: returns true iff the file at path holds a well-formed hierarchy
+    //       written by save() for a network with the n, m and fingerprint
+    //       of G, which then replaces this one; it is unchanged otherwise.
+    //       Every count is checked against the file size before anything
+    //       is allocated, and every offset, rank and arc is checked before
+    //       the hierarchy is adopted.
+    bool open(const std::string & path, const csr_view & G)
+    {
+        std::unique_ptr<std::FILE, int (*)(std::FILE *)> f(std::fopen(path.c_str(), "rb"), std::fclose);
+        if (!f)
+            return false;
+
+        header h;
+        if (std::fread(&h, sizeof(h), 1, f.get()) != 1 ||
+            std::memcmp(h.magic, MAGIC, sizeof(h.magic)) != 0 || h.version != VERSION ||
+            h.n >= NIL || h.n != G.n() || h.m != G.m())
+            return false;
+
+        long here = std::ftell(f.get());
+        if (here < 0 || std::fseek(f.get(), 0, SEEK_END) != 0)
+            return false;
+        long end = std::ftell(f.get());
+        if (end < here || std::fseek(f.get(), here, SEEK_SET) != 0)
+            return false;
+        std::uint64_t left = std::uint64_t(end - here);
+        if (h.up > left / sizeof(arc) || h.down > left / sizeof(arc) ||
+            left != h.n * sizeof(vid) + 2 * (h.n + 1) * sizeof(std::size_t) + (h.up + h.down) * sizeof(arc) ||
+            h.fingerprint != fingerprint(G))
+            return false;
+
+        contraction_hierarchy H;
+        if (!(_read(f.get(), H._rank, h.n) && _read(f.get(), H._up_off, h.n + 1) &&
+              _read(f.get(), H._down_off, h.n + 1) && _read(f.get(), H._up, h.up) &&
+              _read(f.get(), H._down, h.down) && std::fgetc(f.get()) == EOF))
+            return false;
+
+        H._n = h.n;
+        H._m = h.m;
+        H._fingerprint = h.fingerprint;
+        if (!_valid(H))
+            return false;
+        *this = std::move(H);
+        return true;
+    }
+
+private:
+
+    static constexpr const char * MAGIC = "AACH\0\0\0\0";
+    static const std::uint32_t VERSION = 2;
+
+    struct header
+    {
+        char magic[8];
+        std::uint32_t version, reserved;
+        std::uint64_t n, up, down;
+        std::uint64_t m, fingerprint;       // of the network it was built from
+    };
+
+    std::size_t _n;
+    std::size_t _m;                 // arcs of the network it was built from
+    std::uint64_t _fingerprint;     // fingerprint() of that network
+    std::vector<vid> _rank;
+    std::vector<std::size_t> _up_off, _down_off;
+    std::vector<arc> _up, _down;
+
+    template <class X>
+    static bool _write(std::FILE * f, const std::vector<X> & x)
+    {
+        return x.empty() || std::fwrite(x.data(), sizeof(X), x.size(), f) == x.size();
+    }
+
+    template <class X>
+    static bool _read(std::FILE * f, std::vector<X> & x, std::size_t k)
+    {
+        x.resize(k);
+        return k == 0 || std::fread(x.data(), sizeof(X), k, f) == k;
+    }
+
+    // post: returns true iff the offsets of H run from 0 to its arc counts
+    //       without decreasing, rank is a permutation of 0, ..., n-1, every
+    //       arc leads up in rank to a vertex below n with a weight of at
+    //       least 0, and every shortcut skips a vertex ranked below both
+    //       its ends, so that unpacking it ends
+    static bool _valid(const contraction_hierarchy & H)
+    {
+        std::size_t n = H._n;
+        std::vector<char> seen(n, 0);
+
+        for (vid v = 0; v < n; ++v)
+        {
+            if (H._rank[v] >= n || seen[H._rank[v]])
+                return false;
+            seen[H._rank[v]] = 1;
+        }
+        if (H._up_off[0] != 0 || H._up_off[n] != H._up.size() ||
+            H._down_off[0] != 0 || H._down_off[n] != H._down.size())
+            return false;
+        for (vid v = 0; v < n; ++v)
+            if (H._up_off[v] > H._up_off[v+1] || H._down_off[v] > H._down_off[v+1])
+                return false;
+
+        std::atomic<bool> ok(true);
+        parallel_for(0, n, [&](std::size_t v)
+        {
+            auto good = [&](const arc & a)
+            {
+                return a.target < n && H._rank[a.target] > H._rank[v] && a.w >= 0 &&
+                       (a.mid == NIL || (a.mid < n && H._rank[a.mid] < H._rank[v]));
+            };
+            for (auto & a: H.up(vid(v)))
+                if (!good(a))
+                    ok = false;
+            for (auto & a: H.down(vid(v)))
+                if (!good(a))
+                    ok = false;
+        }, 256);
+        return ok;
+    }
+
+    // the graph while it is being contracted: every vertex keeps its arcs
+    // to and from the vertices left, and a witness search workspace is kept
+    // per worker
+    class _builder
+    {
+    public:
+
+        _builder(const csr_view & G): _n(G.n()), _out(G.n()), _in(G.n()), _state(G.n(), LEFT),
+            _priority(G.n(), 0), _deleted(G.n(), 0), _up(G.n()), _down(G.n()),
+            _ws(thread_pool::instance().size())
+        {
+            for (vid v = 0; v < _n; ++v)
+                for (std::size_t i = G.first(v); i < G.first(v+1); ++i)
+                    if (G.target(i) != v)
+                        _add(v, G.target(i), G.cost(i), NIL);
+            for (auto & w: _ws)
+                w.init(_n);
+        }
+
+        void run(contraction_hierarchy & H)
+        {
+            std::vector<vid> left(_n), round, touched;
+            std::vector<std::vector<arc>> shortcuts(_n);
+            std::vector<unsigned char> mark(_n, 0);
+            vid next = 0;
+
+            H._n = _n;
+            H._rank.assign(_n, NIL);
+            for (vid v = 0; v < _n; ++v)
+                left[v] = v;
+
+            parallel_for_workers(0, _n, [&](std::size_t v, std::size_t t)
+            {
+                _priority[v] = _simulate(vid(v), _ws[t], nullptr);
+            }, 64);
+
+            while (!left.empty())
+            {
+                // the vertices of smaller priority than all their neighbors
+                round.clear();
+                for (auto v: left)
+                    if (_isLocalMin(v))
+                        round.push_back(v);
+                for (auto v: round)
+                    _state[v] = ROUND;
+
+                parallel_for_workers(0, round.size(), [&](std::size_t k, std::size_t t)
+                {
+                    vid v = round[k];
+                    shortcuts[v].clear();
+                    _simulate(v, _ws[t], &shortcuts[v]);
+                }, 16);
+
+                // contract the round; its vertices are not adjacent, so the
+                // order among them does not matter
+                touched.clear();
+                for (auto v: round)
+                {
+                    H._rank[v] = next++;
+                    for (auto & a: _out[v])
+                        if (_state[a.target] == LEFT)
+                        {
+                            _up[v].push_back(a);
+                            ++_deleted[a.target];
+                            if (!mark[a.target])
+                            {
+                                mark[a.target] = 1;
+                                touched.push_back(a.target);
+                            }
+                        }
+                    for (auto & a: _in[v])
+                        if (_state[a.target] == LEFT)
+                        {
+                            _down[v].push_back(a);
+                            ++_deleted[a.target];
+                            if (!mark[a.target])
+                            {
+                                mark[a.target] = 1;
+                                touched.push_back(a.target);
+                            }
+                        }
+                }
+                for (auto v: round)
+                {
+                    for (auto & s: shortcuts[v])
+                        _add(s.mid, s.target, s.w, v);
+                    shortcuts[v].clear();
+                    shortcuts[v].shrink_to_fit();
+                    _state[v] = GONE;
+                    _out[v].clear();
+                    _out[v].shrink_to_fit();
+                    _in[v].clear();
+                    _in[v].shrink_to_fit();
+                }
+
+                // drop arcs to contracted vertices, then update priorities
+                parallel_for(0, touched.size(), [&](std::size_t k)
+                {
+                    vid u = touched[k];
+                    auto gone = [&](const arc & a) { return _state[a.target] == GONE; };
+                    _out[u].erase(std::remove_if(_out[u].begin(), _out[u].end(), gone), _out[u].end());
+                    _in[u].erase(std::remove_if(_in[u].begin(), _in[u].end(), gone), _in[u].end());
+                }, 64);
+                parallel_for_workers(0, touched.size(), [&](std::size_t k, std::size_t t)
+                {
+                    _priority[touched[k]] = _simulate(touched[k], _ws[t], nullptr);
+                }, 16);
+                for (auto u: touched)
+                    mark[u] = 0;
+
+                left.erase(std::remove_if(left.begin(), left.end(),
+                                          [&](vid v) { return _state[v] == GONE; }), left.end());
+            }
+
+            _pack(_up, H._up_off, H._up);
+            _pack(_down, H._down_off, H._down);
+        }
+
+    private:
+
+        enum { LEFT, ROUND, GONE };
+
+        // scratch space of one witness search
+        struct workspace
+        {
+            std::vector<double> dist;
+            std::vector<vid> touched;
+            std::vector<unsigned char> target;  // heads of the arcs out of the vertex contracted
+            indexed_heap<double> H;
+
+            void init(std::size_t n)
+            {
+                dist.assign(n, std::numeric_limits<double>::infinity());
+                target.assign(n, 0);
+                H.resize(n);
+            }
+        };
+
+        std::size_t _n;
+        std::vector<std::vector<arc>> _out, _in;    // in-arcs are stored by tail
+        std::vector<unsigned char> _state;
+        std::vector<long> _priority;
+        std::vector<std::size_t> _deleted;          // contracted neighbors
+        std::vector<std::vector<arc>> _up, _down;   // final arcs, by vertex
+        std::vector<workspace> _ws;
+
+        // post: adds arc (u, w) of weight c, or lowers the weight of an
+        //       existing one
+        void _add(vid u, vid w, double c, vid mid)
+        {
+            for (auto & a: _out[u])
+                if (a.target == w)
+                {
+                    if (c < a.w)
+                    {
+                        a.w = c;
+                        a.mid = mid;
+                        for (auto & b: _in[w])
+                            if (b.target == u)
+                            {
+                                b.w = c;
+                                b.mid = mid;
+                            }
+                    }
+                    return;
+                }
+            _out[u].push_back({w, mid, c});
+            _in[w].push_back({u, mid, c});
+        }
+
+        bool _isLocalMin(vid v) const
+        {
+            auto before = [&](vid u)
+            {
+                return _priority[u] < _priority[v] || (_priority[u] == _priority[v] && u < v);
+            };
+            for (auto & a: _out[v])
+                if (_state[a.target] != GONE && before(a.target))
+                    return false;
+            for (auto & a: _in[v])
+                if (_state[a.target] != GONE && before(a.target))
+                    return false;
+            return true;
+        }
+
+        // post: returns the priority of v; if out is not null, appends the
+        //       shortcuts contracting v needs, as arcs whose mid is the tail
+        long _simulate(vid v, workspace & ws, std::vector<arc> * out)
+        {
+            long added = 0, removed = 0;
+            std::size_t targets = 0;
+
+            for (auto & b: _out[v])
+                if (_state[b.target] == LEFT)
+                {
+                    ws.target[b.target] = 1;
+                    ++targets;
+                }
+
+            for (auto & a: _in[v])
+            {
+                if (_state[a.target] != LEFT)
+                    continue;
+                ++removed;
+
+                vid u = a.target;
+                double bound = 0;
+                for (auto & b: _out[v])
+                    if (_state[b.target] == LEFT && b.target != u)
+                        bound = std::max(bound, a.w + b.w);
+                _witness(u, v, bound, targets - ws.target[u], ws);
+
+                for (auto & b: _out[v])
+                    if (_state[b.target] == LEFT && b.target != u && ws.dist[b.target] > a.w + b.w)
+                    {
+                        ++added;
+                        if (out != nullptr)
+                            out->push_back({b.target, u, a.w + b.w});
+                    }
+            }
+            for (auto & b: _out[v])
+                if (_state[b.target] == LEFT)
+                {
+                    ws.target[b.target] = 0;
+                    ++removed;
+                }
+
+            return added - removed + long(_deleted[v]);
+        }
+
+        // post: ws.dist holds distances from u among the vertices left, not
+        //       through v, as far as bound and WITNESS_LIMIT allow; the
+        //       search also stops once all targets other than u are settled
+        void _witness(vid u, vid v, double bound, std::size_t targets, workspace & ws)
+        {
+            for (auto x: ws.touched)
+                ws.dist[x] = std::numeric_limits<double>::infinity();
+            ws.touched.clear();
+
+            ws.dist[u] = 0;
+            ws.touched.push_back(u);
+            ws.H.push(u, 0);
+
+            std::size_t settled = 0;
+            while (targets > 0 && !ws.H.empty() && ws.H.min_key() <= bound && settled++ < WITNESS_LIMIT)
+            {
+                vid x = vid(ws.H.min());
+                ws.H.pop_min();
+                if (x != u && ws.target[x] && --targets == 0)
+                    break;
+                for (auto & a: _out[x])
+                {
+                    vid y = a.target;
+                    if (y == v || _state[y] != LEFT)
+                        continue;
+                    double temp = ws.dist[x] + a.w;
+                    if (temp < ws.dist[y])
+                    {
+                        if (ws.dist[y] == std::numeric_limits<double>::infinity())
+                            ws.touched.push_back(y);
+                        ws.dist[y] = temp;
+                        ws.H.push_or_decrease(y, temp);
+                    }
+                }
+            }
+            ws.H.clear();
+        }
+
+        static void _pack(const std::vector<std::vector<arc>> & a,
+                          std::vector<std::size_t> & off,
+                          std::vector<arc> & out)
+        {
+            off.assign(1, 0);
+            out.clear();
+            for (auto & x: a)
+            {
+                out.insert(out.end(), x.begin(), x.end());
+                off.push_back(out.size());
+            }
+        }
+    };
+};
+
+
+// queries on a contraction hierarchy: Dijkstra's algorithm up the
+// hierarchy from s and, on reversed arcs, from t.  A side stops once its
+// fringe minimum reaches the best path mu found so far.  A vertex is not
+// expanded if a higher vertex already reached gives it a shorter distance
+// (stall on demand), since no shortest path goes through it then.
+class ch_engine
+{
+public:
+
+    // pre: H outlives the engine
+    ch_engine(const contraction_hierarchy & H): _H(H), _mu(0), _meet(NIL)
+    {
+        for (auto & s: _side)
+        {
+            s.dist.assign(H.n(), std::numeric_limits<double>::infinity());
+            s.parent.assign(H.n(), NIL);
+            s.via.assign(H.n(), nullptr);
+            s.Q.resize(H.n());
+        }
+    }
+
+    // pre: s, t < H.n()
+    // post: returns the distance from s to t, or infinity if there is none
+    double run(vid s, vid t)
+    {
+        for (auto & S: _side)
+        {
+            for (auto v: S.touched)
+            {
+                S.dist[v] = std::numeric_limits<double>::infinity();
+                S.parent[v] = NIL;
+                S.via[v] = nullptr;
+            }
+            S.touched.clear();
+        }
+        _mu = std::numeric_limits<double>::infinity();
+        _meet = NIL;
+
+        _side[0].start(s);
+        _side[1].start(t);
+        _update(s);
+
+        while (!_side[0].Q.empty() || !_side[1].Q.empty())
+        {
+            for (int k = 0; k < 2; ++k)
+            {
+                side & S = _side[k];
+                if (!S.Q.empty() && S.Q.min_key() >= _mu)
+                    S.Q.clear();
+                if (S.Q.empty())
+                    continue;
+
+                vid v = vid(S.Q.min());
+                S.Q.pop_min();
+                if (_stalled(k, v))
+                    continue;
+
+                for (auto & a: (k == 0) ? _H.up(v) : _H.down(v))
+                {
+                    double temp = S.dist[v] + a.w;
+                    if (temp < S.dist[a.target])
+                    {
+                        if (S.parent[a.target] == NIL)
+                            S.touched.push_back(a.target);
+                        S.dist[a.target] = temp;
+                        S.parent[a.target] = v;
+                        S.via[a.target] = &a;
+                        S.Q.push_or_decrease(a.target, temp);
+                        _update(a.target);
+                    }
+                }
+            }
+        }
+        return _mu;
+    }
+
+    // post: returns the ids on the path found by the last run, from s to
+    //       t, with every shortcut unpacked, or an empty vector if t was
+    //       not reached
+    std::vector<vid> path() const
+    {
+        std::vector<vid> ans;
+        if (_meet == NIL)
+            return ans;
+
+        // arcs of the hierarchy from s to the meeting vertex, then to t
+        std::vector<std::pair<vid, const contraction_hierarchy::arc *>> arcs;
+        for (vid v = _meet; _side[0].parent[v] != v; v = _side[0].parent[v])
+            arcs.push_back({_side[0].parent[v], _side[0].via[v]});
+        std::reverse(arcs.begin(), arcs.end());
+        vid s = arcs.empty() ? _meet : arcs[0].first;
+
+        std::vector<std::pair<vid, vid>> down;     // (v, parent) is an arc (v, parent)
+        for (vid v = _meet; _side[1].parent[v] != v; v = _side[1].parent[v])
+            down.push_back({v, _side[1].parent[v]});
+
+        ans.push_back(s);
+        for (auto & a: arcs)
+            _unpack(a.first, a.second->target, a.second->mid, ans);
+        for (auto & d: down)
+            _unpack(d.first, d.second, _side[1].via[d.first]->mid, ans);
+        return ans;
+    }
+
+private:
+
+    struct side
+    {
+        std::vector<double> dist;
+        std::vector<vid> parent;
+        std::vector<const contraction_hierarchy::arc *> via;    // arc that reached the vertex
+        std::vector<vid> touched;
+        indexed_heap<double> Q;
+
+        void start(vid s)
+        {
+            touched.push_back(s);
+            dist[s] = 0;
+            parent[s] = s;
+            Q.push(s, 0);
+        }
+    };
+
+    const contraction_hierarchy & _H;
+    side _side[2];              // 0 goes up from s, 1 goes up from t on reversed arcs
+    double _mu;
+    vid _meet;
+
+    void _update(vid v)
+    {
+        double d = _side[0].dist[v] + _side[1].dist[v];
+        if (d < _mu)
+        {
+            _mu = d;
+            _meet = v;
+        }
+    }
+
+    // post: returns true iff an arc from a higher vertex already reached
+    //       gives v a shorter distance on side k
+    bool _stalled(int k, vid v) const
+    {
+        const side & S = _side[k];
+        for (auto & a: (k == 0) ? _H.down(v) : _H.up(v))
+            if (S.dist[a.target] + a.w < S.dist[v])
+                return true;
+        return false;
+    }
+
+    // post: returns the mid of the arc (u, w) of the hierarchy
+    vid _mid(vid u, vid w) const
+    {
+        if (_H.rank(u) < _H.rank(w))
+        {
+            for (auto & a: _H.up(u))
+                if (a.target == w)
+                    return a.mid;
+        }
+        else
+            for (auto & a: _H.down(w))
+                if (a.target == u)
+                    return a.mid;
+        assert(false);
+        return NIL;
+    }
+
+    // post: appends the vertices after u on the unpacked arc (u, w)
+    void _unpack(vid u, vid w, vid mid, std::vector<vid> & out) const
+    {
+        std::vector<std::pair<vid, vid>> S = {{u, w}};
+        std::vector<vid> M = {mid};
+
+        while (!S.empty())
+        {
+            std::pair<vid, vid> e = S.back();
+            vid m = M.back();
+            S.pop_back();
+            M.pop_back();
+
+            if (m == NIL)
+            {
+                out.push_back(e.second);
+                continue;
+            }
+            S.push_back({m, e.second});
+            M.push_back(_mid(m, e.second));
+            S.push_back({e.first, m});
+            M.push_back(_mid(e.first, m));
+        }
+    }
+};
+
+#endif /* ch_h */
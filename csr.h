@@ -0,0 +1,249 @@
+//
+//  csr.h
+//  Header file for an immutable compressed-sparse-row snapshot of a digraph
+//
+
+#ifndef csr_h
+#define csr_h
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cassert>
+#include <limits>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include "view.h"
+
+#ifndef DENSE_VERTEX_ID
+#define DENSE_VERTEX_ID
+
+typedef std::uint32_t vid;                              // dense vertex id
+const vid NIL = std::numeric_limits<vid>::max();        // "no vertex"
+
+#endif
+
+// non-owning view of a digraph stored in compressed-sparse-row form:
+// the out-neighbors of vertex v are _adj[_off[v]], ..., _adj[_off[v+1]-1]
+// and, if the snapshot is weighted, _w[i] is the weight of arc i
+class csr_view
+{
+public:
+
+    csr_view(std::size_t n = 0,
+             const std::size_t * off = nullptr,
+             const vid * adj = nullptr,
+             const double * w = nullptr): _n(n), _off(off), _adj(adj), _w(w)
+    {
+
+    }
+
+    // pre: none
+    // post: returns the number of vertices
+    std::size_t n() const
+    {
+        return _n;
+    }
+
+    // pre: none
+    // post: returns the number of arcs
+    std::size_t m() const
+    {
+        return (_n == 0 ? 0 : _off[_n]);
+    }
+
+    // pre: none
+    // post: returns true iff every arc carries a weight
+    bool isWeighted() const
+    {
+        return (_w != nullptr || m() == 0);
+    }
+
+    std::size_t outdeg(vid v) const
+    {
+        assert(v < _n);
+        return _off[v+1] - _off[v];
+    }
+
+    // pre: v < n()
+    // post: returns the index of the first arc leaving v; arcs of v are
+    //       first(v), ..., first(v+1)-1
+    std::size_t first(vid v) const
+    {
+        assert(v <= _n);
+        return _off[v];
+    }
+
+    // pre: i < m()
+    // post: returns the head of arc i
+    vid target(std::size_t i) const
+    {
+        return _adj[i];
+    }
+
+    // pre: i < m() and the view is weighted
+    // post: returns the weight of arc i
+    double cost(std::size_t i) const
+    {
+        return _w[i];
+    }
+
+    // pre: v < n()
+    // post: returns the out-neighbors of v
+    range<const vid *> Adj(vid v) const
+    {
+        assert(v < _n);
+        return range<const vid *>(_adj + _off[v], _adj + _off[v+1]);
+    }
+
+    // pre: v < n() and the view is weighted
+    // post: returns the weights of the arcs leaving v, parallel to Adj(v)
+    range<const double *> W(vid v) const
+    {
+        assert(v < _n && _w != nullptr);
+        return range<const double *>(_w + _off[v], _w + _off[v+1]);
+    }
+
+    // pre: none
+    // post: off and adj hold the reverse of this digraph in csr form;
+    //       if this view is weighted and w is not null, *w holds its weights
+    void transpose(std::vector<std::size_t> & off,
+                   std::vector<vid> & adj,
+                   std::vector<double> * w = nullptr) const
+    {
+        off.assign(_n + 1, 0);
+        adj.resize(m());
+        if (w != nullptr && _w != nullptr)
+            w->resize(m());
+
+        for (std::size_t i = 0; i < m(); ++i)
+            ++off[_adj[i] + 1];
+        for (vid v = 0; v < _n; ++v)
+            off[v+1] += off[v];
+
+        std::vector<std::size_t> next(off.begin(), off.end() - 1);
+        for (vid v = 0; v < _n; ++v)
+            for (std::size_t i = _off[v]; i < _off[v+1]; ++i)
+            {
+                std::size_t j = next[_adj[i]]++;
+                adj[j] = v;
+                if (w != nullptr && _w != nullptr)
+                    (*w)[j] = _w[i];
+            }
+    }
+
+protected:
+
+    std::size_t _n;              // number of vertices
+    const std::size_t * _off;    // _n+1 offsets into _adj
+    const vid * _adj;            // heads of arcs, grouped by tail
+    const double * _w;           // weights parallel to _adj, or null
+
+};
+
+
+// owning csr snapshot of a digraph whose vertices are of type Vertex;
+// vertices are renumbered 0, ..., n-1 and translated with index() and vertex()
+template <class Vertex>
+class csr: public csr_view
+{
+public:
+
+    csr()
+    {
+        _bind();
+    }
+
+    // pre: off has names.size()+1 non-decreasing entries ending at adj.size();
+    //      w is empty or parallel to adj
+    // post: builds the snapshot; vertex i is names[i]
+    csr(const std::vector<Vertex> & names,
+        std::vector<std::size_t> off,
+        std::vector<vid> adj,
+        std::vector<double> w = std::vector<double>()):
+        _names(names), _offv(std::move(off)), _adjv(std::move(adj)), _wv(std::move(w))
+    {
+        assert(_offv.size() == _names.size() + 1);
+        assert(_wv.empty() || _wv.size() == _adjv.size());
+        for (vid i = 0; i < _names.size(); ++i)
+            _id[_names[i]] = i;
+        _bind();
+    }
+
+    csr(const csr & other): csr_view(), _names(other._names), _id(other._id),
+        _offv(other._offv), _adjv(other._adjv), _wv(other._wv)
+    {
+        _bind();
+    }
+
+    csr(csr && other): csr_view(), _names(std::move(other._names)), _id(std::move(other._id)),
+        _offv(std::move(other._offv)), _adjv(std::move(other._adjv)), _wv(std::move(other._wv))
+    {
+        _bind();
+        other._bind();
+    }
+
+    csr & operator = (csr other)
+    {
+        std::swap(_names, other._names);
+        std::swap(_id, other._id);
+        std::swap(_offv, other._offv);
+        std::swap(_adjv, other._adjv);
+        std::swap(_wv, other._wv);
+        _bind();
+        return *this;
+    }
+
+    bool isVertex(const Vertex & v) const
+    {
+        return (_id.count(v) != 0);
+    }
+
+    // pre: v is a vertex
+    // post: returns the dense id of v
+    vid index(const Vertex & v) const
+    {
+        assert(isVertex(v));
+        return _id.at(v);
+    }
+
+    // pre: i < n()
+    // post: returns the vertex whose dense id is i
+    const Vertex & vertex(vid i) const
+    {
+        assert(i < _n);
+        return _names[i];
+    }
+
+    // pre: none
+    // post: returns the reverse of this snapshot (weights are kept)
+    csr transpose() const
+    {
+        std::vector<std::size_t> off;
+        std::vector<vid> adj;
+        std::vector<double> w;
+        csr_view::transpose(off, adj, _wv.empty() ? nullptr : &w);
+        return csr(_names, std::move(off), std::move(adj), std::move(w));
+    }
+
+private:
+
+    std::vector<Vertex> _names;                 // _names[i] is the vertex with id i
+    std::unordered_map<Vertex, vid> _id;        // _names[_id[v]] = v
+    std::vector<std::size_t> _offv;
+    std::vector<vid> _adjv;
+    std::vector<double> _wv;
+
+    void _bind()
+    {
+        if (_offv.empty())
+            _offv.assign(1, 0);
+        _n = _names.size();
+        _off = _offv.data();
+        _adj = _adjv.data();
+        _w = _wv.empty() && !_adjv.empty() ? nullptr : _wv.data();
+    }
+};
+
+#endif /* csr_h */
@@ -12,8 +12,11 @@
 #include <vector>
 #include <unordered_map>
 #include <cassert>
+#include <algorithm>
+#include "flat_hash.h"
 
-template <class T>
+// Tables is the table policy for the position map (see flat_hash.h)
+template <class T, class Tables = HASH_TABLES>
 class dary_heap
 {
 
@@ -127,7 +130,173 @@ private:
     std::vector<T> _data;      // store heap elements
     std::size_t    _n;         // actual number of heap elements
     std::size_t    _d;         // number of children per node
-    std::unordered_map <T, std::size_t>  _l;    // _data[_l[key]] = key
+    typename Tables::template map<T, std::size_t> _l;    // _data[_l[key]] = key
+};
+
+
+// d-ary heap of the ids 0, ..., n-1 ordered by a key per id.  Where an id
+// sits in the heap is kept in an array indexed by id, so push, decrease_key
+// and pop_min need no hashing, and clear() costs only the current size.
+template <class Key>
+class indexed_heap
+{
+
+public:
+
+    static constexpr std::size_t NONE = std::size_t(-1);
+
+    indexed_heap(std::size_t n = 0, std::size_t d = 4): _pos(n, NONE), _d(d)
+    {
+
+    }
+
+    // post: ids are 0, ..., n-1 and the heap is empty
+    void resize(std::size_t n)
+    {
+        clear();
+        _pos.assign(n, NONE);
+    }
+
+    bool empty() const
+    {
+        return _data.empty();
+    }
+
+    std::size_t size() const
+    {
+        return _data.size();
+    }
+
+    // post: returns true iff id i is in the heap
+    bool contains(std::size_t i) const
+    {
+        return (_pos[i] != NONE);
+    }
+
+    // pre: !empty()
+    // post: returns the id with the smallest key
+    std::size_t min() const
+    {
+        assert(!empty());
+        return _data[0].i;
+    }
+
+    Key min_key() const
+    {
+        assert(!empty());
+        return _data[0].k;
+    }
+
+    // pre: contains(i)
+    Key key(std::size_t i) const
+    {
+        assert(contains(i));
+        return _data[_pos[i]].k;
+    }
+
+    // pre: !contains(i)
+    void push(std::size_t i, const Key & k)
+    {
+        assert(i < _pos.size() && !contains(i));
+        _data.push_back({k, i});
+        _pos[i] = _data.size() - 1;
+        _up(_pos[i]);
+    }
+
+    // pre: contains(i) and k is not larger than the key of i
+    void decrease_key(std::size_t i, const Key & k)
+    {
+        assert(contains(i) && !(key(i) < k));
+        _data[_pos[i]].k = k;
+        _up(_pos[i]);
+    }
+
+    // post: pushes i, or lowers its key to k if that is smaller; returns
+    //       true iff the heap changed
+    bool push_or_decrease(std::size_t i, const Key & k)
+    {
+        if (!contains(i))
+            push(i, k);
+        else if (k < _data[_pos[i]].k)
+            decrease_key(i, k);
+        else
+            return false;
+        return true;
+    }
+
+    //deletes the root
+    void pop_min()
+    {
+        assert(!empty());
+
+        _pos[_data[0].i] = NONE;
+        entry last = _data.back();
+        _data.pop_back();
+        if (_data.empty())
+            return;
+
+        _data[0] = last;
+        _pos[last.i] = 0;
+        _down(0);
+    }
+
+    // post: the heap is empty
+    void clear()
+    {
+        for (auto & e: _data)
+            _pos[e.i] = NONE;
+        _data.clear();
+    }
+
+private:
+
+    struct entry
+    {
+        Key k;
+        std::size_t i;
+    };
+
+    std::vector<entry> _data;           // heap ordered by key
+    std::vector<std::size_t> _pos;      // _data[_pos[i]].i == i, or NONE
+    std::size_t _d;                     // number of children per node
+
+    void _up(std::size_t j)
+    {
+        entry x = _data[j];
+        while (j > 0)
+        {
+            std::size_t parent = (j-1)/_d;
+            if (!(x.k < _data[parent].k))
+                break;
+            _data[j] = _data[parent];
+            _pos[_data[j].i] = j;
+            j = parent;
+        }
+        _data[j] = x;
+        _pos[x.i] = j;
+    }
+
+    void _down(std::size_t j)
+    {
+        entry x = _data[j];
+        std::size_t n = _data.size();
+
+        while (j*_d + 1 < n)
+        {
+            std::size_t left(j*_d + 1), right(std::min(n, (j+1)*_d + 1)), m(left);
+            for (std::size_t c = left+1; c < right; ++c)
+                if (_data[c].k < _data[m].k)
+                    m = c;
+
+            if (!(_data[m].k < x.k))
+                break;
+            _data[j] = _data[m];
+            _pos[_data[j].i] = j;
+            j = m;
+        }
+        _data[j] = x;
+        _pos[x.i] = j;
+    }
 };
 
 #endif /* dary_heap_h */
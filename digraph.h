@@ -20,8 +20,75 @@
 #include <utility>
 #include <list>
 #include <stack>
+#include "csr.h"
+#include "scc.h"
+#include "parallel.h"
+#include "euler.h"
+#include "view.h"
+#include "flat_hash.h"
+
+template <class Vertex, class Weight, class Tables>
+class transposed_view;
+
+// the out-neighbors of one vertex of a digraph: a set of vertices, or, if
+// the edges carry weights, a map from each neighbor to the weight of the
+// edge to it, so the weight is found with the neighbor in one lookup.
+// Tables is the table policy (see flat_hash.h).
+template <class Vertex, class Weight, class Tables>
+struct adjacency
+{
+    typedef typename Tables::template map<Vertex, Weight> type;
+    typedef key_iterator<typename type::const_iterator> iterator;   // yields the neighbors
+
+    // post: adds d to a, with weight Weight() if it is new
+    static void insert(type & a, const Vertex & d)
+    {
+        a.emplace(d, Weight());
+    }
+
+    // post: adds to a the edge from v whose reverse is x
+    static void insert_reverse(type & a, const Vertex & v, const typename type::value_type & x)
+    {
+        a[v] = x.second;
+    }
+
+    // post: returns false; in-neighbor sets carry no weights to copy
+    template <class Map, class InMap>
+    static bool assign(Map &, const InMap &)
+    {
+        return false;
+    }
+};
+
+template <class Vertex, class Tables>
+struct adjacency<Vertex, void, Tables>
+{
+    typedef typename Tables::template set<Vertex> type;
+    typedef typename type::const_iterator iterator;
+
+    static void insert(type & a, const Vertex & d)
+    {
+        a.insert(d);
+    }
+
+    static void insert_reverse(type & a, const Vertex & v, const Vertex &)
+    {
+        a.insert(v);
+    }
+
+    // post: t = in; returns true
+    template <class Map>
+    static bool assign(Map & t, const Map & in)
+    {
+        t = in;
+        return true;
+    }
+};
 
-template <class Vertex>
+// a digraph whose vertices are of type Vertex; if Weight is not void,
+// every edge carries a Weight kept next to its head (see network).  Its
+// hash tables are those of the policy Tables.
+template <class Vertex, class Weight = void, class Tables = HASH_TABLES>
 class digraph
 {
 public:
@@ -30,14 +97,24 @@ public:
     typedef std::pair<Vertex, Vertex> DEdge;
     typedef std::vector<Vertex> DPath;
 
-    typedef std::unordered_set<Vertex> VertexSet;
+    typedef typename Tables::template set<Vertex> VertexSet;
     typedef std::unordered_map<Vertex, Vertex> V2V;
     typedef std::unordered_map<Vertex, int> V2I;
 
+    typedef adjacency<Vertex, Weight, Tables> Out;
+    typedef typename Out::type OutSet;                  // out-neighbors of a vertex
+    typedef typename Tables::template map<Vertex, OutSet> Adjacency;
+    typedef typename Tables::template map<Vertex, vid> Numbering;
+
+    typedef range<key_iterator<typename Adjacency::const_iterator>> VertexView;
+    typedef range<typename Out::iterator> AdjView;
+    typedef range<typename VertexSet::const_iterator> InAdjView;
+
 
     // constructor
+    // in_index: keep an index of in-neighbors (see index_in_edges)
 
-    digraph()
+    digraph(bool in_index = false): _indexed(in_index), _epoch(1)
     {
 
     }
@@ -50,7 +127,7 @@ public:
     std::size_t m() const
     {
         std::size_t ans(0);
-        for (auto p: _t)
+        for (auto & p: _t)
             ans += p.second.size();
 
         return ans;
@@ -64,7 +141,7 @@ public:
     bool isEdge(const Vertex &s, const Vertex & d) const
     {
         assert(isVertex(s) && isVertex(d));
-        return (Adj(s).count(d) != 0);
+        return (_t.at(s).count(d) != 0);
     }
 
     std::size_t outdeg(const Vertex & v) const
@@ -73,50 +150,135 @@ public:
         return _t.at(v).size();
     }
 
+    // pre: v is a vertex
+    // post: returns the number of edges into v; O(1) with the in-neighbor
+    //       index, O(n + m) without it
     std::size_t indeg(const Vertex &v) const
     {
-        std::size_t ans(0);
-
         assert(isVertex(v));
-        for (auto p: _t)
+        if (_indexed)
+            return _in.at(v).size();
+
+        std::size_t ans(0);
+        for (auto & p: _t)
             ans += p.second.count(v);
 
         return ans;
     }
 
     // pre: none
-    // post: returns the set of vertices in the graph
-    VertexSet V() const
+    // post: returns a number that changes whenever a vertex or an edge is
+    //       added or removed, so derived data can be cached against it
+    std::size_t epoch() const
     {
-        VertexSet ans;
-        for (auto p: _t)
-            ans.insert(p.first);
+        return _epoch;
+    }
 
-        return ans;
+    // pre: none
+    // post: returns true iff the in-neighbor index is kept
+    bool isInIndexed() const
+    {
+        return _indexed;
+    }
+
+    // pre: none
+    // post: returns a view of the set of vertices in the graph; the view
+    //       is invalidated by add_vertex
+    VertexView V() const
+    {
+        return keys(_t);
     }
    
 
     // pre: v is a vertex
-    // post: returns the set of vertices adjacent to v
-    VertexSet Adj(const Vertex & v) const
+    // post: returns a view of the set of vertices adjacent to v; the view
+    //       is invalidated by any change to the out-edges of v
+    AdjView Adj(const Vertex & v) const
     {
         assert(isVertex(v));
-        return _t.at(v);
+        const OutSet & a = _t.at(v);
+        return AdjView(a.begin(), a.end());
+    }
+
+    // pre: the in-neighbor index is kept
+    // post: returns an O(1) read-only view of the reverse of this digraph
+    transposed_view<Vertex, Weight, Tables> transposed() const
+    {
+        return transposed_view<Vertex, Weight, Tables>(*this);
+    }
+
+    // pre: v is a vertex and the in-neighbor index is kept
+    // post: returns a view of the set of vertices with an edge into v; the
+    //       view is invalidated by any change to the in-edges of v
+    InAdjView InAdj(const Vertex & v) const
+    {
+        assert(isVertex(v) && _indexed);
+        const VertexSet & a = _in.at(v);
+        return InAdjView(a.begin(), a.end());
     }
 
+    // pre: none
+    // post: returns the digraph with every edge reversed; weights are kept
     digraph reverse() const
     {
         digraph R;
-        for (auto v: V())
+        if (_indexed && Out::assign(R._t, _in))
+            return R;
+
+        for (auto & v: V())
             R.add_vertex(v);
 
-        for (auto v: V())
-            for (auto w: Adj(v))
-                R.add_edge(w, v);
+        for (auto & p: _t)
+            for (auto & x: p.second)
+                Out::insert_reverse(R._t[_head(x)], p.first, x);
 
         return R;
     }
 
+    // pre: none
+    // post: returns an immutable csr snapshot of this digraph with dense
+    //       vertex ids; later changes to this digraph do not affect it
+    csr<Vertex> freeze() const
+    {
+        std::vector<Vertex> names;
+        Numbering id;
+        std::vector<std::size_t> off;
+        std::vector<vid> adj;
+
+        _number(names, id);
+        _pack(_t, names, id, off, adj);
+
+        return csr<Vertex>(names, std::move(off), std::move(adj));
+    }
+
+    // pre: none
+    // post: G is a csr snapshot of this digraph and R one of its reverse,
+    //       both with the same dense ids; R is read straight off the
+    //       in-neighbor index when it is kept
+    void freeze(csr<Vertex> & G, csr<Vertex> & R) const
+    {
+        G = freeze();
+        if (!_indexed)
+        {
+            R = G.transpose();
+            return;
+        }
+
+        std::vector<Vertex> names(G.n());
+        Numbering id;
+        std::vector<std::size_t> off;
+        std::vector<vid> adj;
+
+        for (vid v = 0; v < G.n(); ++v)
+        {
+            names[v] = G.vertex(v);
+            id[names[v]] = v;
+        }
+        _pack(_in, names, id, off, adj);
+
+        R = csr<Vertex>(names, std::move(off), std::move(adj));
+    }
+
     //mutator functions
     
     // pre: none
@@ -124,7 +286,10 @@ public:
     void add_vertex(const Vertex & v)
     {
         assert(!isVertex(v));
-        _t[v] = VertexSet();
+        _t[v] = OutSet();
+        if (_indexed)
+            _in[v] = VertexSet();
+        ++_epoch;
     }
 
     // pre: v and w are different vertices
@@ -132,7 +297,21 @@ public:
     void add_edge(const Vertex & s, const Vertex & d)
     {
         assert(isVertex(s) && isVertex(d));
-        _t[s].insert(d);
+        Out::insert(_t[s], d);
+        if (_indexed)
+            _in[d].insert(s);
+        ++_epoch;
+    }
+
+    // pre: every endpoint in e is a vertex
+    // post: adds every edge of e; the edges are split by a hash of their
+    //       tail (and of their head for the in-neighbor index) so that each
+    //       adjacency set is filled by one thread
+    void add_edges(const std::vector<DEdge> & e)
+    {
+        _add_edges(e, [](const DEdge & p) -> const Vertex & { return p.first; },
+                   [](const DEdge & p) -> const Vertex & { return p.second; },
+                   [](OutSet & a, const DEdge & p) { Out::insert(a, p.second); });
     }
 
     // pre: v and w are vertices
@@ -141,132 +320,351 @@ public:
     {
         assert(isVertex(s) && isVertex(d));
         _t[s].erase(d);
+        if (_indexed)
+            _in[d].erase(s);
+        ++_epoch;
     }
 
-    //connected component algorithms
-    
-    //DFS for Kosaraju's connected components algorithm
-    void Kdfs(const Vertex & v,
-              V2I & visited,
-              std::list<Vertex> & lv) const
+    // pre: none
+    // post: the in-neighbor index is kept iff on; turning it on builds it
+    //       in O(n + m), after which add_edge and remove_edge maintain it
+    void index_in_edges(bool on = true)
     {
-        visited[v] = 1;
-        for (auto w: Adj(v))
-        {
-            if (visited.count(w) == 0)
-                Kdfs(w, visited, lv);
-        }
-        lv.push_front(v);
+        _indexed = on;
+        _in.clear();
+        if (!on)
+            return;
+
+        for (auto & p: _t)
+            _in[p.first];
+        for (auto & p: _t)
+            for (auto & x: p.second)
+                _in[_head(x)].insert(p.first);
     }
-    
+
+    //connected component algorithms
+
     //Kosaraju's connected components algorithm
     V2I Kscc() const
     {
-        V2I visited, ans;
-        digraph R = reverse();
-        std::list<Vertex> lv;
+        csr<Vertex> G, R;
+        freeze(G, R);
+        return _names(G, scc_engine(G, R).kosaraju());
+    }
+
+    //Tarjan's connected component algorithm
+    V2I Tscc() const
+    {
+        csr<Vertex> G, R;
+        freeze(G, R);
+        return _names(G, scc_engine(G, R).tarjan());
+    }
 
-        // dfs on reverse graph to obtain list of vertices sorted in
-        // reverse post order number
-        for (auto v: R.V())
-            if (visited.count(v) == 0)
-                R.Kdfs(v, visited, lv);
+    // pre: none
+    // post: returns true iff every vertex has as many in-edges as out-edges
+    //       and all edges lie in one strongly connected component
+    bool isEulerian() const
+    {
+        csr<Vertex> G, R;
+        freeze(G, R);
 
-        visited.clear();
-        std::size_t name(1);
-        for (auto v: lv)
+        for (vid v = 0; v < G.n(); ++v)
+            if (G.outdeg(v) != R.outdeg(v))
+                return false;
+
+        // with balanced degrees, weak and strong connectivity agree
+        scc_result c = scc_engine(G, R).tarjan();
+        vid comp = NIL;
+        for (vid v = 0; v < G.n(); ++v)
         {
-            std::list<Vertex> component;
-            if (visited.count(v) == 0)
-            {
-                Kdfs(v, visited, component);
-                for (auto w: component)
-                    ans[w] = name;
-                ++name;
-            }
+            if (G.outdeg(v) == 0)
+                continue;
+            if (comp == NIL)
+                comp = c.comp[v];
+            else if (comp != c.comp[v])
+                return false;
         }
+        return (n() > 0);
+    }
+
+    // pre: isEulerian()
+    // post: returns a closed walk that uses every edge exactly once, as its
+    //       m()+1 vertices
+    DPath eulerianCycle() const
+    {
+        assert(isEulerian());
+        csr<Vertex> G = freeze();
+        std::vector<vid> tour(G.m() + 1);
+
+        vid start = 0;
+        while (start + 1 < G.n() && G.outdeg(start) == 0)
+            ++start;
+        euler_tour(G, start, tour.data());
+
+        DPath ans;
+        ans.reserve(tour.size());
+        for (auto v: tour)
+            ans.push_back(G.vertex(v));
         return ans;
     }
 
-    //DFS for Tarjan's connected component algorithm
-    void Tdfs(const Vertex & v,
-              V2I & pre,
-              V2I & low,
-              V2I & ans,
-              std::size_t &time,
-              std::size_t &name,
-              std::stack<Vertex> & S
-              ) const
+    //multithreaded connected component algorithm for large digraphs
+    V2I Pscc() const
+    {
+        csr<Vertex> G, R;
+        freeze(G, R);
+        return _names(G, scc_engine(G, R).parallel());
+    }
+
+
+protected:
+
+    // post: records a change that digraph does not see itself, such as a
+    //       new edge weight in a derived class
+    void _changed()
+    {
+        ++_epoch;
+    }
+
+    // post: returns the adjacency of every vertex
+    const Adjacency & _adjacency() const
+    {
+        return _t;
+    }
+
+    // pre: v is a vertex
+    // post: returns the out-neighbors of v, with their weights if any
+    const OutSet & _out(const Vertex & v) const
     {
-        pre[v] = low[v] = time++;
-        S.push(v);
+        return _t.at(v);
+    }
 
-        for (auto w: Adj(v))
+    OutSet & _out(const Vertex & v)
+    {
+        return _t.at(v);
+    }
+
+    // pre: tail(x) and head(x) are vertices for every x in e
+    // post: link(a, x) has been called for every x in e, where a is the
+    //       out-neighbors of tail(x), and the in-neighbor index is updated;
+    //       the edges are split by a hash of their tail (and of their head
+    //       for the index) so that each set is filled by one thread
+    template <class E, class Tail, class Head, class Link>
+    void _add_edges(const std::vector<E> & e, Tail tail, Head head, Link link)
+    {
+        std::size_t parts = thread_pool::instance().size();
+        std::vector<std::vector<const E *>> out(parts), in(_indexed ? parts : 0);
+        std::hash<Vertex> h;
+
+        for (auto & x: e)
         {
-            if (pre.count(w) == 0)
-                Tdfs(w, pre, low, ans, time, name, S);
-            low[v] = std::min(low[v], low[w]); 
+            assert(isVertex(tail(x)) && isVertex(head(x)));
+            out[h(tail(x)) % parts].push_back(&x);
+            if (_indexed)
+                in[h(head(x)) % parts].push_back(&x);
         }
 
+        // only the inner sets change, so concurrent lookups in _t are safe
+        parallel_for(0, parts, [&](std::size_t t)
+        {
+            for (auto x: out[t])
+                link(_t.find(tail(*x))->second, *x);
+            if (_indexed)
+                for (auto x: in[t])
+                    _in.find(head(*x))->second.insert(tail(*x));
+        }, 1);
+        ++_epoch;
+    }
 
-        if (low[v] == pre[v])
+    // pre: Weight is not void
+    // post: same as freeze(), with arc weights taken from the out-neighbor
+    //       maps in the same pass
+    csr<Vertex> _freeze_weighted() const
+    {
+        std::vector<Vertex> names;
+        Numbering id;
+        std::vector<std::size_t> off;
+        std::vector<vid> adj;
+        std::vector<double> w;
+
+        std::size_t arcs = m();
+
+        _number(names, id);
+        off.assign(1, 0);
+        off.reserve(names.size() + 1);
+        adj.reserve(arcs);
+        w.reserve(arcs);
+        for (auto & v: names)
         {
-            Vertex top;
-            std::size_t _n = n();
-            do
+            for (auto & x: _t.at(v))
             {
-                top = S.top();
-                ans[top] = name;
-                S.pop();
-                low[top] = _n;   // disable cross edges
-            } while (top != v);
-            ++name;
+                adj.push_back(id.at(x.first));
+                w.push_back(x.second);
+            }
+            off.push_back(adj.size());
         }
+
+        return csr<Vertex>(names, std::move(off), std::move(adj), std::move(w));
     }
 
-    //Tarjan's connected component algorithm
-    V2I Tscc() const
+private:
+
+    Adjacency _t;
+    typename Tables::template map<Vertex, VertexSet> _in;   // _in[d] holds every s with an edge (s, d)
+    bool _indexed;                               // true iff _in is kept up to date
+    std::size_t _epoch;                          // bumped by every change to the digraph
+
+    // post: names lists the vertices and id[names[i]] = i
+    void _number(std::vector<Vertex> & names,
+                 Numbering & id) const
     {
-        V2I pre, low, ans;
-        std::size_t time(1), name(1);
-        std::stack<Vertex> S;
+        names.reserve(n());
+        id.reserve(n());
+        for (auto & p: _t)
+        {
+            id[p.first] = names.size();
+            names.push_back(p.first);
+        }
+    }
 
-        for (auto v: V())
+    // post: off and adj hold adjacency t in csr form under the numbering id
+    template <class Map>
+    static void _pack(const Map & t,
+                      const std::vector<Vertex> & names,
+                      const Numbering & id,
+                      std::vector<std::size_t> & off,
+                      std::vector<vid> & adj)
+    {
+        off.assign(1, 0);
+        off.reserve(names.size() + 1);
+        for (auto & v: names)
         {
-            if (pre.count(v) == 0)
-                Tdfs(v, pre, low, ans, time, name, S);
+            for (auto & x: t.at(v))
+                adj.push_back(id.at(_head(x)));
+            off.push_back(adj.size());
         }
+    }
+
+    static const Vertex & _head(const Vertex & x)
+    {
+        return x;
+    }
+
+    template <class W>
+    static const Vertex & _head(const std::pair<const Vertex, W> & x)
+    {
+        return x.first;
+    }
+
+    // post: translates dense component ids of G to names 1, 2, ... keyed by vertex
+    static V2I _names(const csr<Vertex> & G, const scc_result & r)
+    {
+        V2I ans;
+        for (vid v = 0; v < G.n(); ++v)
+            ans[G.vertex(v)] = r.comp[v] + 1;
         return ans;
     }
+};
+
+
+// read-only view of the reverse of a digraph that keeps its in-neighbor
+// index; it costs O(1) to make and reflects later changes to the digraph
+template <class Vertex, class Weight = void, class Tables = HASH_TABLES>
+class transposed_view
+{
+public:
+
+    typedef typename digraph<Vertex, Weight, Tables>::VertexView VertexView;
+    typedef typename digraph<Vertex, Weight, Tables>::InAdjView AdjView;
+    typedef typename digraph<Vertex, Weight, Tables>::AdjView InAdjView;
+
+    // pre: D keeps its in-neighbor index and outlives this view
+    transposed_view(const digraph<Vertex, Weight, Tables> & D): _D(D)
+    {
+        assert(D.isInIndexed());
+    }
+
+    std::size_t n() const
+    {
+        return _D.n();
+    }
+
+    std::size_t m() const
+    {
+        return _D.m();
+    }
+
+    bool isVertex(const Vertex & v) const
+    {
+        return _D.isVertex(v);
+    }
+
+    bool isEdge(const Vertex & s, const Vertex & d) const
+    {
+        return _D.isEdge(d, s);
+    }
+
+    std::size_t outdeg(const Vertex & v) const
+    {
+        return _D.indeg(v);
+    }
+
+    std::size_t indeg(const Vertex & v) const
+    {
+        return _D.outdeg(v);
+    }
+
+    VertexView V() const
+    {
+        return _D.V();
+    }
+
+    AdjView Adj(const Vertex & v) const
+    {
+        return _D.InAdj(v);
+    }
 
+    InAdjView InAdj(const Vertex & v) const
+    {
+        return _D.Adj(v);
+    }
+
+    // pre: none
+    // post: returns a csr snapshot of the reverse digraph
+    csr<Vertex> freeze() const
+    {
+        csr<Vertex> G, R;
+        _D.freeze(G, R);
+        return R;
+    }
 
 private:
 
-    std::unordered_map<Vertex, VertexSet> _t;
+    const digraph<Vertex, Weight, Tables> & _D;
 };
 
 
-template <class T>
-std::ostream & operator << (std::ostream & os, const digraph<T> & D)
+template <class T, class Tables>
+std::ostream & operator << (std::ostream & os, const digraph<T, void, Tables> & D)
 {
     os << D.n() << " " << D.m() << std::endl;
-    for (auto v: D.V())
+    for (auto & v: D.V())
         os << v << " ";
     os << std::endl;
 
-    for (auto v: D.V())
-        for (auto w: D.Adj(v))
+    for (auto & v: D.V())
+        for (auto & w: D.Adj(v))
             os << v << " " << w << std::endl;
     return os;
 }
 
-template <class T>
-std::istream & operator >> (std::istream & is, digraph<T> & D)
+template <class T, class Tables>
+std::istream & operator >> (std::istream & is, digraph<T, void, Tables> & D)
 {
     std::size_t n, m;
     is >> n >> m;
     std::string s, d;
-    D = digraph<T>();
+    D = digraph<T, void, Tables>(D.isInIndexed());
     for (std::size_t i = 1; i <= n; ++i)
     {
         is >> s;
@@ -10,7 +10,14 @@
 #define ds_h
 
 #include <unordered_map>
-template <class T>
+#include <cassert>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "flat_hash.h"
+
+template <class T, class Tables = HASH_TABLES>
 class ds
 {
 public:
@@ -85,7 +92,117 @@ public:
 
 
 private:
-    std::unordered_map<T, node*> _data;
+    typename Tables::template map<T, node*> _data;
+};
+
+
+// disjoint set over the elements 0, ..., n-1 that many threads may use at
+// once.  Each element is one atomic word holding its parent (low 32 bits)
+// and its rank (high 32 bits), so a root and its rank change together in a
+// single compare-and-swap.  find never waits on other threads: it halves
+// the path as it goes, and a failed halving step is simply skipped.
+class concurrent_ds
+{
+public:
+
+    // post: n singleton sets {0}, ..., {n-1}
+    concurrent_ds(std::size_t n): _n(n), _data(new std::atomic<std::uint64_t>[n])
+    {
+        assert(n <= 0xffffffffu);
+        for (std::size_t x = 0; x < n; ++x)
+            _data[x].store(_pack(x, 0), std::memory_order_relaxed);
+    }
+
+    std::size_t size() const
+    {
+        return _n;
+    }
+
+    // pre: x < size()
+    // post: returns the root of the tree containing x
+    std::uint32_t find(std::uint32_t x)
+    {
+        assert(x < _n);
+        for (;;)
+        {
+            std::uint64_t wx = _data[x].load(std::memory_order_acquire);
+            std::uint32_t p = _parent(wx);
+            if (p == x)
+                return x;
+
+            std::uint32_t gp = _parent(_data[p].load(std::memory_order_acquire));
+            if (p != gp)        // path halving: x skips over its parent
+                _data[x].compare_exchange_weak(wx, _pack(gp, _rank(wx)), std::memory_order_release,
+                                               std::memory_order_relaxed);
+            x = gp;
+        }
+    }
+
+    // pre: x, y < size()
+    // post: returns true iff x and y are in the same set at some point
+    //       during the call
+    bool same(std::uint32_t x, std::uint32_t y)
+    {
+        for (;;)
+        {
+            std::uint32_t rx = find(x), ry = find(y);
+            if (rx == ry)
+                return true;
+            if (_parent(_data[rx].load(std::memory_order_acquire)) == rx)
+                return false;   // rx was still a root after ry was found
+        }
+    }
+
+    // pre: x, y < size()
+    // post: returns true if two trees are combined; false otherwise
+    bool join(std::uint32_t x, std::uint32_t y)
+    {
+        for (;;)
+        {
+            std::uint32_t rx = find(x), ry = find(y);
+            if (rx == ry)           // x and y share the same root
+                return false;
+
+            std::uint64_t wx = _data[rx].load(std::memory_order_acquire);
+            std::uint64_t wy = _data[ry].load(std::memory_order_acquire);
+            if (_parent(wx) != rx || _parent(wy) != ry)
+                continue;           // another thread moved a root; retry
+
+            // link the lower rank under the higher, ties by index
+            if (_rank(wx) < _rank(wy) || (_rank(wx) == _rank(wy) && rx > ry))
+            {
+                std::swap(rx, ry);
+                std::swap(wx, wy);
+            }
+
+            if (!_data[ry].compare_exchange_strong(wy, _pack(rx, _rank(wy)), std::memory_order_acq_rel))
+                continue;
+
+            if (_rank(wx) == _rank(wy))     // best effort; a lost race only costs balance
+                _data[rx].compare_exchange_strong(wx, _pack(rx, _rank(wx) + 1), std::memory_order_acq_rel);
+            return true;
+        }
+    }
+
+private:
+
+    std::size_t _n;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> _data;
+
+    static std::uint64_t _pack(std::uint64_t parent, std::uint64_t rank)
+    {
+        return (rank << 32) | parent;
+    }
+
+    static std::uint32_t _parent(std::uint64_t w)
+    {
+        return std::uint32_t(w);
+    }
+
+    static std::uint32_t _rank(std::uint64_t w)
+    {
+        return std::uint32_t(w >> 32);
+    }
 };
 
 #endif /* ds_h */
@@ -10,6 +10,7 @@
 #define edge_h
 
 #include <iostream>
+#include <cstdint>
 
 template <class T>
 struct Edge
@@ -41,10 +42,15 @@ namespace std
     class hash<Edge<T>>
     {
     public:
+        // the head hash is added to a multiple of the tail hash and the sum
+        // is mixed, so (a, b) and (b, a) differ and (a, a) is not 0
         std::size_t operator() (const Edge<T> & e) const
         {
-            return std::hash<T>() (e.s) ^
-                    std::hash<T>() (e.d);
+            std::uint64_t x = std::uint64_t(std::hash<T>() (e.s)) * 0x9e3779b97f4a7c15ULL +
+                              std::hash<T>() (e.d);
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+            return std::size_t(x ^ (x >> 31));
         }
     };
 }
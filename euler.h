@@ -0,0 +1,121 @@
+//
+//  euler.h
+//  Header file for linear-time Euler tours (Hierholzer's algorithm)
+//
+
+#ifndef euler_h
+#define euler_h
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cassert>
+#include "csr.h"
+
+// Hierholzer's algorithm without recursion or graph copies: every vertex
+// keeps a cursor into its list of incident edges, edges are marked used
+// in a bit array, and the tour is written back to front into a buffer of
+// m+1 vertices supplied by the caller.
+
+// pre: edges lists the m edges of an undirected graph on vertices
+//      0, ..., n-1 in which every vertex has even degree; start < n; out
+//      has room for m+1 vertices
+// post: returns true iff every edge is reachable from start, in which
+//       case out[0], ..., out[m] is a closed walk from start that uses
+//       every edge exactly once
+inline bool euler_tour(std::size_t n,
+                       const std::vector<std::pair<vid, vid>> & edges,
+                       vid start,
+                       vid * out)
+{
+    std::size_t m = edges.size();
+    std::vector<std::size_t> off(n + 1, 0);
+    std::vector<std::uint32_t> inc(2 * m);           // edge ids incident to each vertex
+    std::vector<std::uint64_t> used((m + 63) / 64, 0);
+    std::vector<vid> S;
+
+    assert(start < n);
+    for (auto & e: edges)
+    {
+        ++off[e.first + 1];
+        ++off[e.second + 1];
+    }
+    for (std::size_t v = 0; v < n; ++v)
+        off[v+1] += off[v];
+
+    std::vector<std::size_t> cursor(off.begin(), off.end() - 1);
+    for (std::uint32_t i = 0; i < m; ++i)
+    {
+        inc[cursor[edges[i].first]++] = i;
+        inc[cursor[edges[i].second]++] = i;
+    }
+    std::copy(off.begin(), off.end() - 1, cursor.begin());
+
+    std::size_t k = m + 1;      // out[k..m] is the tour found so far
+    S.reserve(m + 1);
+    S.push_back(start);
+
+    while (!S.empty())
+    {
+        vid v = S.back();
+        std::size_t & i = cursor[v];
+
+        while (i < off[v+1] && (used[inc[i] / 64] >> (inc[i] % 64)) & 1)
+            ++i;
+
+        if (i < off[v+1])
+        {
+            std::uint32_t e = inc[i++];
+            used[e / 64] |= std::uint64_t(1) << (e % 64);
+            S.push_back(edges[e].first == v ? edges[e].second : edges[e].first);
+        }
+        else   // v has no more unused edges
+        {
+            S.pop_back();
+            if (k == 0)
+                return false;
+            out[--k] = v;
+        }
+    }
+
+    return (k == 0);
+}
+
+// pre: G is a digraph in csr form in which every vertex has as many
+//      in-arcs as out-arcs; start < G.n(); out has room for G.m()+1
+//      vertices
+// post: returns true iff every arc is reachable from start, in which case
+//       out[0], ..., out[m] is a closed directed walk from start that
+//       uses every arc exactly once
+inline bool euler_tour(const csr_view & G, vid start, vid * out)
+{
+    std::size_t m = G.m();
+    std::vector<std::size_t> cursor(G.n());
+    std::vector<vid> S;
+
+    assert(start < G.n());
+    for (vid v = 0; v < G.n(); ++v)
+        cursor[v] = G.first(v);
+
+    std::size_t k = m + 1;
+    S.reserve(m + 1);
+    S.push_back(start);
+
+    while (!S.empty())
+    {
+        vid v = S.back();
+        if (cursor[v] < G.first(v+1))
+            S.push_back(G.target(cursor[v]++));
+        else
+        {
+            S.pop_back();
+            if (k == 0)
+                return false;
+            out[--k] = v;
+        }
+    }
+
+    return (k == 0);
+}
+
+#endif /* euler_h */
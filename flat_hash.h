@@ -0,0 +1,629 @@
+//
+//  flat_hash.h
+//  Header file for flat open-addressing hash maps and sets, and the table
+//  policies that let the graph containers choose between them and the
+//  standard ones
+//
+
+#ifndef flat_hash_h
+#define flat_hash_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLAT_HASH_SSE2 1
+#endif
+
+// open addressing in the style of Swiss tables: the elements sit in one
+// array of slots, and a parallel array holds one control byte per slot,
+// which is EMPTY, DELETED, or the low 7 bits of the hash of the element in
+// the slot.  A lookup scans the control bytes 16 at a time (one SSE2
+// compare where available) and only compares keys whose 7 bits match, so
+// it rarely touches more than one slot.  Erased slots become DELETED and
+// are reused by later inserts; the table is rebuilt when empty slots run
+// short.  There is one allocation per table rather than one per element.
+//
+// Unlike the std containers, an insert that grows the table moves every
+// element, so it invalidates references and iterators as well.
+namespace flat_detail
+{
+    const std::int8_t EMPTY = -128;         // 0b10000000
+    const std::int8_t DELETED = -2;         // 0b11111110
+    const std::size_t GROUP = 16;           // control bytes scanned at once
+
+    // post: returns a hash with well-spread bits; std::hash is often the
+    //       identity on integers
+    inline std::size_t mix(std::size_t h)
+    {
+        std::uint64_t x = std::uint64_t(h) * 0x9e3779b97f4a7c15ULL;
+        return std::size_t(x ^ (x >> 29));
+    }
+
+    // pre: mask != 0
+    // post: returns the index of the lowest set bit of mask
+    inline unsigned lowest(unsigned mask)
+    {
+#if defined(__GNUC__)
+        return unsigned(__builtin_ctz(mask));
+#else
+        unsigned i = 0;
+        while (!(mask & 1))
+        {
+            mask >>= 1;
+            ++i;
+        }
+        return i;
+#endif
+    }
+
+    // GROUP control bytes, with bit i of a mask standing for byte i
+    class group
+    {
+    public:
+
+        explicit group(const std::int8_t * p)
+        {
+#ifdef FLAT_HASH_SSE2
+            _c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+#else
+            std::memcpy(_c, p, GROUP);
+#endif
+        }
+
+        // post: returns the bytes equal to h
+        unsigned match(std::int8_t h) const
+        {
+#ifdef FLAT_HASH_SSE2
+            return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h), _c)));
+#else
+            unsigned m = 0;
+            for (std::size_t i = 0; i < GROUP; ++i)
+                if (_c[i] == h)
+                    m |= 1u << i;
+            return m;
+#endif
+        }
+
+        unsigned match_empty() const
+        {
+            return match(EMPTY);
+        }
+
+        // post: returns the bytes that are EMPTY or DELETED, the only ones
+        //       with the high bit set
+        unsigned match_free() const
+        {
+#ifdef FLAT_HASH_SSE2
+            return unsigned(_mm_movemask_epi8(_c));
+#else
+            unsigned m = 0;
+            for (std::size_t i = 0; i < GROUP; ++i)
+                if (_c[i] < 0)
+                    m |= 1u << i;
+            return m;
+#endif
+        }
+
+    private:
+#ifdef FLAT_HASH_SSE2
+        __m128i _c;
+#else
+        std::int8_t _c[GROUP];
+#endif
+    };
+
+    template <class Key>
+    struct set_key
+    {
+        static const Key & get(const Key & x)
+        {
+            return x;
+        }
+    };
+
+    template <class Key, class Pair>
+    struct map_key
+    {
+        static const Key & get(const Pair & x)
+        {
+            return x.first;
+        }
+    };
+}
+
+
+// the table shared by flat_map and flat_set; Slot is the element type and
+// KeyOf::get(slot) its key
+template <class Key, class Slot, class KeyOf, class Hash, class Eq>
+class flat_table
+{
+public:
+
+    typedef Key key_type;
+    typedef Slot value_type;
+    typedef std::size_t size_type;
+
+    template <bool Const>
+    class basic_iterator
+    {
+    public:
+
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Slot value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef typename std::conditional<Const, const Slot *, Slot *>::type pointer;
+        typedef typename std::conditional<Const, const Slot &, Slot &>::type reference;
+
+        basic_iterator(): _ctrl(nullptr), _slots(nullptr), _i(0), _cap(0)
+        {
+
+        }
+
+        basic_iterator(const std::int8_t * ctrl, Slot * slots, std::size_t i, std::size_t cap):
+            _ctrl(ctrl), _slots(slots), _i(i), _cap(cap)
+        {
+
+        }
+
+        // a const_iterator can be made from an iterator
+        template <bool C, class = typename std::enable_if<Const && !C>::type>
+        basic_iterator(const basic_iterator<C> & it): _ctrl(it._ctrl), _slots(it._slots), _i(it._i), _cap(it._cap)
+        {
+
+        }
+
+        reference operator * () const
+        {
+            return _slots[_i];
+        }
+
+        pointer operator -> () const
+        {
+            return _slots + _i;
+        }
+
+        basic_iterator & operator ++ ()
+        {
+            ++_i;
+            _skip();
+            return *this;
+        }
+
+        basic_iterator operator ++ (int)
+        {
+            basic_iterator old(*this);
+            ++*this;
+            return old;
+        }
+
+        bool operator == (const basic_iterator & other) const
+        {
+            return (_i == other._i);
+        }
+
+        bool operator != (const basic_iterator & other) const
+        {
+            return (_i != other._i);
+        }
+
+    private:
+
+        template <bool> friend class basic_iterator;
+        friend class flat_table;
+
+        const std::int8_t * _ctrl;
+        Slot * _slots;
+        std::size_t _i, _cap;
+
+        // post: moves forward to the next full slot, or to the end
+        void _skip()
+        {
+            while (_i < _cap && _ctrl[_i] < 0)
+                ++_i;
+        }
+    };
+
+    typedef basic_iterator<false> iterator;
+    typedef basic_iterator<true> const_iterator;
+
+    flat_table(): _ctrl(nullptr), _slots(nullptr), _cap(0), _size(0), _deleted(0)
+    {
+
+    }
+
+    flat_table(const flat_table & other): flat_table()
+    {
+        if (other._size == 0)
+            return;
+        _allocate(other._cap);
+        std::memcpy(_ctrl, other._ctrl, _cap + flat_detail::GROUP);
+        for (std::size_t i = 0; i < _cap; ++i)
+            if (_ctrl[i] >= 0)
+                new (_slots + i) Slot(other._slots[i]);
+        _size = other._size;
+        _deleted = other._deleted;
+    }
+
+    flat_table(flat_table && other): flat_table()
+    {
+        swap(other);
+    }
+
+    flat_table & operator = (flat_table other)
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~flat_table()
+    {
+        _release();
+    }
+
+    void swap(flat_table & other)
+    {
+        std::swap(_ctrl, other._ctrl);
+        std::swap(_slots, other._slots);
+        std::swap(_cap, other._cap);
+        std::swap(_size, other._size);
+        std::swap(_deleted, other._deleted);
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    bool empty() const
+    {
+        return (_size == 0);
+    }
+
+    iterator begin()
+    {
+        iterator it(_ctrl, _slots, 0, _cap);
+        it._skip();
+        return it;
+    }
+
+    iterator end()
+    {
+        return iterator(_ctrl, _slots, _cap, _cap);
+    }
+
+    const_iterator begin() const
+    {
+        const_iterator it(_ctrl, _slots, 0, _cap);
+        it._skip();
+        return it;
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(_ctrl, _slots, _cap, _cap);
+    }
+
+    iterator find(const Key & k)
+    {
+        std::size_t i = _find(k, _hash(k));
+        return (i == NONE ? end() : iterator(_ctrl, _slots, i, _cap));
+    }
+
+    const_iterator find(const Key & k) const
+    {
+        std::size_t i = _find(k, _hash(k));
+        return (i == NONE ? end() : const_iterator(_ctrl, _slots, i, _cap));
+    }
+
+    std::size_t count(const Key & k) const
+    {
+        return (_find(k, _hash(k)) == NONE ? 0 : 1);
+    }
+
+    // post: removes k if present; returns the number of elements removed
+    std::size_t erase(const Key & k)
+    {
+        std::size_t i = _find(k, _hash(k));
+        if (i == NONE)
+            return 0;
+        _slots[i].~Slot();
+        _set(i, flat_detail::DELETED);
+        --_size;
+        ++_deleted;
+        return 1;
+    }
+
+    // post: the table is empty; its capacity is kept
+    void clear()
+    {
+        for (std::size_t i = 0; i < _cap; ++i)
+            if (_ctrl[i] >= 0)
+                _slots[i].~Slot();
+        if (_cap > 0)
+            std::memset(_ctrl, flat_detail::EMPTY, _cap + flat_detail::GROUP);
+        _size = _deleted = 0;
+    }
+
+    // post: n elements fit without growing the table
+    void reserve(std::size_t n)
+    {
+        if (n + _deleted > _limit(_cap))
+            _rehash(_capacity_for(n));
+    }
+
+protected:
+
+    static constexpr std::size_t NONE = std::size_t(-1);
+
+    // post: returns the slot of k and true if k was inserted, in which
+    //       case make(p) has constructed the new element at address p
+    template <class Make>
+    std::pair<iterator, bool> _emplace(const Key & k, Make make)
+    {
+        std::size_t h = _hash(k), i = _find(k, h);
+        if (i != NONE)
+            return {iterator(_ctrl, _slots, i, _cap), false};
+
+        if (_size + _deleted + 1 > _limit(_cap))
+            _rehash(_capacity_for(2 * (_size + 1)));
+
+        i = _free(h);
+        make(static_cast<void *>(_slots + i));
+        if (_ctrl[i] == flat_detail::DELETED)
+            --_deleted;
+        _set(i, std::int8_t(h & 0x7f));
+        ++_size;
+        return {iterator(_ctrl, _slots, i, _cap), true};
+    }
+
+private:
+
+    std::int8_t * _ctrl;        // _cap control bytes, then copies of the first GROUP
+    Slot * _slots;              // _cap slots, constructed where _ctrl is not negative
+    std::size_t _cap;           // 0 or a power of two at least GROUP
+    std::size_t _size;          // full slots
+    std::size_t _deleted;       // DELETED slots
+
+    static std::size_t _hash(const Key & k)
+    {
+        return flat_detail::mix(Hash() (k));
+    }
+
+    // post: returns how many slots may be full or DELETED, so that a
+    //       probe always meets an EMPTY slot
+    static std::size_t _limit(std::size_t cap)
+    {
+        return cap - cap / 8;
+    }
+
+    static std::size_t _capacity_for(std::size_t n)
+    {
+        std::size_t cap = flat_detail::GROUP;
+        while (_limit(cap) < n)
+            cap *= 2;
+        return cap;
+    }
+
+    // post: ctrl byte i is c, and so is its copy past the end if it has one
+    void _set(std::size_t i, std::int8_t c)
+    {
+        _ctrl[i] = c;
+        if (i < flat_detail::GROUP)
+            _ctrl[_cap + i] = c;
+    }
+
+    // post: returns the slot holding k, or NONE
+    std::size_t _find(const Key & k, std::size_t h) const
+    {
+        if (_cap == 0)
+            return NONE;
+
+        std::size_t mask = _cap - 1, pos = (h >> 7) & mask;
+        for (;;)
+        {
+            flat_detail::group g(_ctrl + pos);
+            for (unsigned m = g.match(std::int8_t(h & 0x7f)); m != 0; m &= m - 1)
+            {
+                std::size_t i = (pos + flat_detail::lowest(m)) & mask;
+                if (Eq() (KeyOf::get(_slots[i]), k))
+                    return i;
+            }
+            if (g.match_empty() != 0)
+                return NONE;
+            pos = (pos + flat_detail::GROUP) & mask;
+        }
+    }
+
+    // pre: the table has an EMPTY slot
+    // post: returns the first EMPTY or DELETED slot on the probe path of h
+    std::size_t _free(std::size_t h) const
+    {
+        std::size_t mask = _cap - 1, pos = (h >> 7) & mask;
+        for (;;)
+        {
+            unsigned m = flat_detail::group(_ctrl + pos).match_free();
+            if (m != 0)
+                return (pos + flat_detail::lowest(m)) & mask;
+            pos = (pos + flat_detail::GROUP) & mask;
+        }
+    }
+
+    void _allocate(std::size_t cap)
+    {
+        _cap = cap;
+        _ctrl = new std::int8_t[cap + flat_detail::GROUP];
+        std::memset(_ctrl, flat_detail::EMPTY, cap + flat_detail::GROUP);
+        _slots = std::allocator<Slot>().allocate(cap);
+    }
+
+    void _release()
+    {
+        if (_cap == 0)
+            return;
+        for (std::size_t i = 0; i < _cap; ++i)
+            if (_ctrl[i] >= 0)
+                _slots[i].~Slot();
+        std::allocator<Slot>().deallocate(_slots, _cap);
+        delete [] _ctrl;
+        _ctrl = nullptr;
+        _slots = nullptr;
+        _cap = 0;
+    }
+
+    // post: the elements are moved to a table of cap slots with no DELETED
+    void _rehash(std::size_t cap)
+    {
+        flat_table old;
+        swap(old);
+        _allocate(cap);
+
+        for (std::size_t i = 0; i < old._cap; ++i)
+            if (old._ctrl[i] >= 0)
+            {
+                std::size_t h = _hash(KeyOf::get(old._slots[i])), j = _free(h);
+                new (_slots + j) Slot(std::move(old._slots[i]));
+                _set(j, std::int8_t(h & 0x7f));
+            }
+        _size = old._size;
+    }
+};
+
+
+template <class Key, class Value, class Hash = std::hash<Key>, class Eq = std::equal_to<Key>>
+class flat_map: public flat_table<Key, std::pair<const Key, Value>,
+                                  flat_detail::map_key<Key, std::pair<const Key, Value>>, Hash, Eq>
+{
+    typedef flat_table<Key, std::pair<const Key, Value>,
+                       flat_detail::map_key<Key, std::pair<const Key, Value>>, Hash, Eq> table;
+
+public:
+
+    typedef Value mapped_type;
+    typedef typename table::value_type value_type;
+    typedef typename table::iterator iterator;
+    typedef typename table::const_iterator const_iterator;
+
+    // post: same as for std::unordered_map; a is passed to the constructor
+    //       of the value
+    template <class... A>
+    std::pair<iterator, bool> emplace(const Key & k, A &&... a)
+    {
+        return table::_emplace(k, [&](void * p)
+        {
+            new (p) value_type(std::piecewise_construct, std::forward_as_tuple(k),
+                               std::forward_as_tuple(std::forward<A>(a)...));
+        });
+    }
+
+    std::pair<iterator, bool> insert(const value_type & x)
+    {
+        return table::_emplace(x.first, [&](void * p) { new (p) value_type(x); });
+    }
+
+    Value & operator [] (const Key & k)
+    {
+        return emplace(k).first->second;
+    }
+
+    Value & at(const Key & k)
+    {
+        iterator it = table::find(k);
+        if (it == table::end())
+            throw std::out_of_range("flat_map::at");
+        return it->second;
+    }
+
+    const Value & at(const Key & k) const
+    {
+        const_iterator it = table::find(k);
+        if (it == table::end())
+            throw std::out_of_range("flat_map::at");
+        return it->second;
+    }
+};
+
+
+template <class Key, class Hash = std::hash<Key>, class Eq = std::equal_to<Key>>
+class flat_set: public flat_table<Key, Key, flat_detail::set_key<Key>, Hash, Eq>
+{
+    typedef flat_table<Key, Key, flat_detail::set_key<Key>, Hash, Eq> table;
+
+public:
+
+    // elements of a set cannot be changed in place
+    typedef typename table::const_iterator iterator;
+    typedef typename table::const_iterator const_iterator;
+
+    const_iterator begin() const
+    {
+        return table::begin();
+    }
+
+    const_iterator end() const
+    {
+        return table::end();
+    }
+
+    const_iterator find(const Key & k) const
+    {
+        return table::find(k);
+    }
+
+    std::pair<iterator, bool> insert(const Key & k)
+    {
+        return table::_emplace(k, [&](void * p) { new (p) Key(k); });
+    }
+
+    template <class It>
+    void insert(It b, It e)
+    {
+        for (; b != e; ++b)
+            insert(*b);
+    }
+
+    std::pair<iterator, bool> emplace(const Key & k)
+    {
+        return insert(k);
+    }
+};
+
+
+// table policies: a class with member templates map<K, V> and set<K>.  The
+// graph containers take one as a template parameter (digraph, network,
+// dary_heap, ph, ds) or, for graph, through HASH_TABLES.
+struct flat_tables
+{
+    template <class K, class V>
+    using map = flat_map<K, V>;
+
+    template <class K>
+    using set = flat_set<K>;
+};
+
+struct std_tables
+{
+    template <class K, class V>
+    using map = std::unordered_map<K, V>;
+
+    template <class K>
+    using set = std::unordered_set<K>;
+};
+
+// the policy used when none is given
+#ifndef HASH_TABLES
+#define HASH_TABLES flat_tables
+#endif
+
+#endif /* flat_hash_h */
@@ -22,8 +22,8 @@ class flow: public network<T>
     {
         _source = source;
         _sink = sink;
-        digraph<T>::add_vertex(_source);
-        digraph<T>::add_vertex(_sink);
+        network<T>::add_vertex(_source);
+        network<T>::add_vertex(_sink);
     }
 
 
@@ -32,17 +32,17 @@ class flow: public network<T>
         if (v == _source || v == _sink)
             return;
 
-        digraph<T>::add_vertex(v);
+        network<T>::add_vertex(v);
     }
     bool empty() const
     {
-        return (digraph<T>::m() == 0);
+        return (network<T>::m() == 0);
     }
 
     double value() const
     {
         double ans(0.0);
-        for (auto n: digraph<T>::Adj(_source))
+        for (auto & n: network<T>::Adj(_source))
             ans += network<T>::cost(_source, n);
 
         return ans;
@@ -50,12 +50,12 @@ class flow: public network<T>
 
     void operator +=(const flow& f)
     {
-        for (auto e: f.E())
+        for (auto e: f.edges())
         {
-            if (digraph<T>::isEdge(e.s, e.d))
-                network<T>::increase_cost(e.s, e.d, f.cost(e.s, e.d));
+            if (network<T>::isEdge(e.s, e.d))
+                network<T>::increase_cost(e.s, e.d, e.w);
             else
-                network<T>::add_edge(e.s, e.d, f.cost(e.s, e.d));
+                network<T>::add_edge(e.s, e.d, e.w);
         }
     }
 
@@ -75,15 +75,15 @@ public:
     {
         _source = source;
         _sink = sink;
-        digraph<T>::add_vertex(_source);
-        digraph<T>::add_vertex(_sink);
+        network<T>::add_vertex(_source);
+        network<T>::add_vertex(_sink);
     }
 
     void add_vertex(const T & v)
     {
         if (v == _source || v == _sink)
             return;
-        digraph<T>::add_vertex(v);
+        network<T>::add_vertex(v);
     }
 
     T source() const
@@ -116,7 +116,7 @@ public:
             T front = q.front();
             q.pop();
 
-            for (auto n: digraph<T>::Adj(front))
+            for (auto & n: network<T>::Adj(front))
             {
                 if (parent.count(n) == 0) // unvisited
                 {
@@ -136,7 +136,7 @@ public:
             w = std::min(w, network<T>::cost(parent[v], v));
 
         flow<T> ans(_source, _sink);
-        for (auto v: digraph<T>::V())
+        for (auto & v: network<T>::V())
                 ans.add_vertex(v);
 
         for (T v = _sink; v != _source; v = parent[v])
@@ -150,7 +150,7 @@ public:
             if (network<T>::cost(parent[v], v) == 0.0)
                 network<T>::remove_edge(parent[v], v);
 
-            if (digraph<T>::isEdge(v, parent[v]))
+            if (network<T>::isEdge(v, parent[v]))
                 network<T>::increase_cost(v, parent[v], w);
             else
                 network<T>::add_edge(v, parent[v], w);
@@ -172,7 +172,7 @@ public:
 
         flow<T> ans(_source, _sink);
 
-        for (auto v: digraph<T>::V())
+        for (auto & v: network<T>::V())
             if (v != _source && v!= _sink)
                 ans.add_vertex(v);
 
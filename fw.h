@@ -0,0 +1,184 @@
+//
+//  fw.h
+//  Header file for a dense adjacency matrix and a cache-blocked parallel
+//  Floyd-Warshall
+//
+
+#ifndef fw_h
+#define fw_h
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include "csr.h"
+#include "parallel.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// side of a tile of the blocked Floyd-Warshall; a multiple of 8, and small
+// enough that three tiles of doubles fit in the L2 cache
+#ifndef FW_TILE
+#define FW_TILE 64
+#endif
+
+// a dense n x n matrix of arc weights, infinity meaning "no arc"; rows are
+// padded to a whole number of tiles, and the padding is never reached
+//
+// floyd_warshall() replaces the weights by distances, tile by tile: for
+// every block of FW_TILE values of k, the diagonal tile is closed first,
+// then the tiles in its row and column, then all the others, each phase in
+// parallel over its tiles.  The inner loop is a min-plus update of one row
+// of a tile, done with AVX-512 or AVX2 when the compiler targets them
+// (e.g. -march=native), and by plain code otherwise.
+class adjacency_matrix
+{
+public:
+
+    // pre: none
+    // post: an n x n matrix with 0 on the diagonal and infinity elsewhere
+    explicit adjacency_matrix(std::size_t n = 0): _n(n),
+        _stride((n + FW_TILE - 1) / FW_TILE * FW_TILE),
+        _d(_stride * _stride, std::numeric_limits<double>::infinity())
+    {
+        for (std::size_t v = 0; v < _n; ++v)
+            _d[v * _stride + v] = 0;
+    }
+
+    // pre: G is weighted
+    // post: the matrix of G; a loop (v, v) of negative weight is kept
+    adjacency_matrix(const csr_view & G): adjacency_matrix(G.n())
+    {
+        parallel_for(0, _n, [&](std::size_t v)
+        {
+            for (std::size_t i = G.first(vid(v)); i < G.first(vid(v+1)); ++i)
+            {
+                double & x = _d[v * _stride + G.target(i)];
+                x = std::min(x, G.cost(i));
+            }
+        }, 64);
+    }
+
+    std::size_t n() const
+    {
+        return _n;
+    }
+
+    // pre: v, w < n()
+    double operator () (std::size_t v, std::size_t w) const
+    {
+        assert(v < _n && w < _n);
+        return _d[v * _stride + w];
+    }
+
+    // pre: v, w < n()
+    // post: the entry for (v, w) is x
+    void set(std::size_t v, std::size_t w, double x)
+    {
+        assert(v < _n && w < _n);
+        _d[v * _stride + w] = x;
+    }
+
+    // pre: v < n()
+    // post: returns the n() entries of row v
+    const double * row(std::size_t v) const
+    {
+        assert(v < _n);
+        return _d.data() + v * _stride;
+    }
+
+    // pre: none
+    // post: every entry (v, w) is the distance from v to w, or infinity if
+    //       there is none; returns false iff there is a negative cycle, in
+    //       which case the entries of the vertices that can reach one are
+    //       not meaningful (see negative())
+    bool floyd_warshall()
+    {
+        std::size_t T = _stride / FW_TILE;
+
+        for (std::size_t K = 0; K < T; ++K)
+        {
+            _close(K, K, K);
+
+            parallel_for(0, 2 * T, [&](std::size_t x)
+            {
+                std::size_t j = x / 2;
+                if (j == K)
+                    return;
+                if (x % 2 == 0)
+                    _close(K, j, K);    // row of the diagonal tile
+                else
+                    _close(j, K, K);    // column of it
+            }, 1);
+
+            parallel_for(0, T * T, [&](std::size_t x)
+            {
+                std::size_t I = x / T, J = x % T;
+                if (I != K && J != K)
+                    _close(I, J, K);
+            }, 1);
+        }
+
+        for (std::size_t v = 0; v < _n; ++v)
+            if (negative(v))
+                return false;
+        return true;
+    }
+
+    // pre: floyd_warshall() has run and v < n()
+    // post: returns true iff v is on a negative cycle, which shows as a
+    //       negative entry on the diagonal
+    bool negative(std::size_t v) const
+    {
+        return (*this)(v, v) < 0;
+    }
+
+private:
+
+    std::size_t _n;
+    std::size_t _stride;        // n rounded up to a multiple of FW_TILE
+    std::vector<double> _d;     // _d[v * _stride + w] is the entry for (v, w)
+
+    // post: tile (I, J) has been relaxed through every k of tile column K,
+    //       reading tile (I, K) and tile (K, J), which may be (I, J) itself
+    void _close(std::size_t I, std::size_t J, std::size_t K)
+    {
+        double * c = _d.data() + I * FW_TILE * _stride + J * FW_TILE;
+        const double * a = _d.data() + I * FW_TILE * _stride + K * FW_TILE;
+        const double * b = _d.data() + K * FW_TILE * _stride + J * FW_TILE;
+
+        for (std::size_t k = 0; k < FW_TILE; ++k)
+            for (std::size_t i = 0; i < FW_TILE; ++i)
+            {
+                double aik = a[i * _stride + k];
+                if (aik != std::numeric_limits<double>::infinity())
+                    _row(c + i * _stride, aik, b + k * _stride);
+            }
+    }
+
+    // post: c[j] = min(c[j], aik + b[j]) for every j < FW_TILE
+    static void _row(double * c, double aik, const double * b)
+    {
+#if defined(__AVX512F__)
+        __m512d x = _mm512_set1_pd(aik);
+        for (std::size_t j = 0; j < FW_TILE; j += 8)
+        {
+            __m512d y = _mm512_loadu_pd(c + j), z = _mm512_add_pd(x, _mm512_loadu_pd(b + j));
+            _mm512_storeu_pd(c + j, _mm512_mask_blend_pd(_mm512_cmp_pd_mask(z, y, _CMP_LT_OQ), y, z));
+        }
+#elif defined(__AVX2__)
+        __m256d x = _mm256_set1_pd(aik);
+        for (std::size_t j = 0; j < FW_TILE; j += 4)
+            _mm256_storeu_pd(c + j, _mm256_min_pd(_mm256_loadu_pd(c + j),
+                                                  _mm256_add_pd(x, _mm256_loadu_pd(b + j))));
+#else
+        for (std::size_t j = 0; j < FW_TILE; ++j)
+            c[j] = std::min(c[j], aik + b[j]);
+#endif
+    }
+};
+
+#endif /* fw_h */
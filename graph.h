@@ -18,6 +18,17 @@
 #include <queue>
 #include <stack>
 #include <vector>
+#include <limits>
+#include "symtab.h"
+#include "view.h"
+#include "csr.h"
+#include "bfs.h"
+#include "cc.h"
+#include "bcc.h"
+#include "analyze.h"
+#include "euler.h"
+#include "parallel.h"
+#include "flat_hash.h"
 
 
 #ifndef HASH_PAIR_OF_STRINGS
@@ -52,8 +63,13 @@ public:
     typedef std::pair<Vertex, Vertex> Edge;
     typedef std::unordered_set<Edge> EdgeSet;
 
+    typedef HASH_TABLES::set<vid> IdSet;        // set of dense vertex ids
+
+    typedef range<std::vector<Vertex>::const_iterator> VertexView;
+    typedef range<name_iterator<IdSet::const_iterator, Vertex>> AdjView;
+
     // default constructor
-    graph()
+    graph(): _epoch(1), _csr_epoch(0), _cc_epoch(0), _bcc_epoch(0), _analysis_epoch(0)
     {
 
     }
@@ -73,24 +89,20 @@ public:
     {
         std::size_t ans(0);
 
-        for (auto p: _t)
-            ans += p.second.size();
+        for (auto & a: _t)
+            ans += a.size();
 
         return ans / 2;
 
     }
 
     // pre: none
-    // post: returns the set of vertices
+    // post: returns a view of the set of vertices; the view is
+    //       invalidated by add_vertex
 
-    VertexSet V() const
+    VertexView V() const
     {
-        VertexSet ans;
-
-        for (auto p: _t)
-            ans.insert(p.first);
-
-        return ans;
+        return VertexView(_names.names().begin(), _names.names().end());
     }
 
     // pre: none
@@ -106,7 +118,22 @@ public:
 
     bool isVertex(const Vertex & v) const
     {
-        return (_t.count(v) == 1);
+        return _names.contains(v);
+    }
+
+    // pre: v is a vertex
+    // post: returns the dense id of v; ids are 0, ..., n()-1 in order of insertion
+    vid index(const Vertex & v) const
+    {
+        assert(isVertex(v));
+        return _names.find(v);
+    }
+
+    // pre: i < n()
+    // post: returns the vertex whose dense id is i
+    const Vertex & name(vid i) const
+    {
+        return _names.name(i);
     }
 
     // pre: v is a vertex
@@ -114,49 +141,24 @@ public:
 
     std::size_t deg(const Vertex & v) const
     {
-        assert(isVertex(v));
-        return _t.at(v).size();  // _t[v].size()
+        return _t[index(v)].size();
     }
 
     // pre: v is a vertex
-    // post: returns the set of vertices adjacent to v
+    // post: returns a view of the set of vertices adjacent to v; the view
+    //       is invalidated by any change to the edges of v
 
-    VertexSet Adj(const Vertex &v) const
+    AdjView Adj(const Vertex &v) const
     {
-        assert(isVertex(v));
-        return _t.at(v);
-
+        return names(_t[index(v)], _names.names());
     }
 
     V2V bfs(const Vertex & source) const
     {
-        assert(isVertex(source));
-
-        std::queue<Vertex> Q;
-        V2V parent;
-
-        // initialization
-        Q.push(source);
-        parent[source] = source;
-
-        // loop
-        while (!Q.empty())
-        {
-            Vertex front = Q.front();
-            Q.pop();
-
-            for (auto w: Adj(front))
-            {
-                if (parent.count(w) == 0) // w is not visited
-                {
-                    Q.push(w);
-                    parent[w] = front;
-                }
-            }
-
-        }
-
-        return parent;
+        csr_view G = frozen();
+        bfs_engine E(G, G);
+        E.run(index(source));
+        return _toV2V(E.parents());
     }
 
 
@@ -164,26 +166,27 @@ public:
     {
         assert(isVertex(source));
 
-        std::stack<Vertex> S;
+        std::stack<vid> S;
 
-        V2V parent;
-        std::unordered_map<Vertex, std::size_t> pre;  // preorder number of each vertex
+        std::vector<vid> parent(n(), NIL);
+        std::vector<bool> visited(n(), false);
 
         // init
-        S.push(source);
+        S.push(index(source));
 
         // loop
 
         while (!S.empty())
         {
-            Vertex top = S.top();
+            vid top = S.top();
 
-            if (pre.count(top) == 0) // not visited
+            if (!visited[top]) // not visited
             {
-                pre[top] = time++;
-                for (auto w: Adj(top))
+                visited[top] = true;
+                ++time;
+                for (auto w: _t[top])
                 {
-                    if (pre.count(w) == 0)
+                    if (!visited[w])
                     {
                         S.push(w);
                         parent[w] = top;
@@ -197,7 +200,7 @@ public:
 
         }
 
-        return parent;
+        return _toV2V(parent);
     }
 
     void dfs(const Vertex & source,
@@ -210,60 +213,122 @@ public:
     {
         assert(isVertex(source));
 
-        pre[source] = time++;
-        low[source] = pre[source];
-        for (auto w: Adj(source))
-        {
-            if (pre.count(w) == 0) // unvisited neighbor so (source, w) is a tree edge
-            {
-                tree[w] = source;
-                dfs(w, time, pre, post, low, tree, back);
-                low[source] = std::min(low[source], low[w]);
+        std::size_t none = std::numeric_limits<std::size_t>::max();
+        std::vector<std::size_t> ipre(n(), none), ipost(n(), none), ilow(n(), none);
+        std::vector<vid> itree(n(), NIL), iback(n(), NIL);
 
+        // translate the state of earlier searches to dense ids
+        for (auto p: pre)
+            ipre[index(p.first)] = p.second;
+        for (auto p: tree)
+            itree[index(p.first)] = index(p.second);
 
-            }
-            else if (tree.count(source) == 0 || tree[source] != w)
+        _dfs(index(source), time, ipre, ipost, ilow, itree, iback);
+
+        for (vid i = 0; i < n(); ++i)
+        {
+            if (ipre[i] == none || pre.count(_names.name(i)) != 0)
             {
-                    // (source, w) is a back edge
-                back[source] = w;
-                low[source] = std::min(low[source], pre[w]);
+                if (iback[i] != NIL)
+                    back[_names.name(i)] = _names.name(iback[i]);
+                continue;
             }
-
+            pre[_names.name(i)] = ipre[i];
+            post[_names.name(i)] = ipost[i];
+            low[_names.name(i)] = ilow[i];
+            if (itree[i] != NIL)
+                tree[_names.name(i)] = _names.name(itree[i]);
+            if (iback[i] != NIL)
+                back[_names.name(i)] = _names.name(iback[i]);
         }
 
-        post[source] = time++;
-
     }
 
     // pre: none
     // post: returns the number of connnected components
     std::size_t c() const
     {
-        std::size_t ans(0);
-        VertexSet visited;
+        return components().count;
+    }
 
-        for (auto v: V())
+    // pre: none
+    // post: returns the connected components; comp[i] is the component of
+    //       the vertex with dense id i.  The result is cached until the
+    //       graph is next changed, so it must not be called concurrently
+    //       with itself on a graph that has changed since the last call
+    const cc_result & components() const
+    {
+        if (_cc_epoch != _epoch)
         {
-            if (visited.count(v) == 0)   // has not been visited
-            {
-                ++ans;
-                V2V parent = bfs(v);
-                for (auto p: parent)
-                    visited.insert(p.first);
-            }
+            csr_view G = frozen();
+            _cc = cc_engine(G).run();
+            _cc_epoch = _epoch;
         }
+        return _cc;
+    }
 
+    // pre: none
+    // post: returns the articulation points, bridges and biconnected
+    //       components, by dense id (see bcc_result); comp is indexed by
+    //       the arcs of freeze().  Like components(), the result is cached
+    //       until the graph is next changed
+    const bcc_result & biconnected() const
+    {
+        if (_bcc_epoch != _epoch)
+        {
+            csr_view G = frozen();
+            _bcc = bcc_engine(G).run();
+            _bcc_epoch = _epoch;
+        }
+        return _bcc;
+    }
+
+    // pre: none
+    // post: returns the vertices whose removal disconnects their component
+    VertexSet articulationPoints() const
+    {
+        VertexSet ans;
+        for (auto v: biconnected().articulation)
+            ans.insert(_names.name(v));
         return ans;
     }
 
+    // pre: none
+    // post: returns the edges whose removal disconnects their component
+    EdgeSet bridges() const
+    {
+        EdgeSet ans;
+        for (auto & e: biconnected().bridges)
+            ans.insert({_names.name(e.first), _names.name(e.second)});
+        return ans;
+    }
+
+    // pre: none
+    // post: returns the component count, bipartiteness, acyclicity and
+    //       degree spread of the graph, all found by one traversal.  Like
+    //       components(), the result is cached until the graph is next
+    //       changed, and it refreshes that cache too
+    const analysis_result & analyze() const
+    {
+        if (_analysis_epoch != _epoch)
+        {
+            csr_view G = frozen();
+            _analysis = analysis_engine(G).run();
+            _analysis_epoch = _epoch;
+            _cc = _analysis.cc;
+            _cc_epoch = _epoch;
+        }
+        return _analysis;
+    }
+
     bool isConnected() const
     {
-        return (c() == 1);
+        return (analyze().cc.count == 1);
     }
 
     bool isAcyclic() const
     {
-        return (n() == m() + c());
+        return analyze().acyclic;
     }
 
     bool isTree() const
@@ -273,89 +338,71 @@ public:
 
     bool isBipartite() const
     {
-        V2I color;
-
-        for (auto v: V())
-        {
-            if (color.count(v) == 0)
-            {
-                std::queue<Vertex> Q;
-                Q.push(v);
-                color[v] = 0;
-
-                while (!Q.empty())
-                {
-                    Vertex front = Q.front();
-                    Q.pop();
-
-                    for (auto w: Adj(front))
-                    {
-                        if (color.count(w) == 0)
-                        {
-                            Q.push(w);
-                            color[w] = 1 - color[front];
-                        }
-                        else
-                        {
-                            if (color[w] == color[front])
-                                return false;
-                        }
-                    }
-                }
-            }
-        }
-        return true;
+        return analyze().bipartite;
     }
 
     bool isComplete() const
     {
-        std::size_t nv = n();
-        return (2*m() == nv*(nv-1));
+        const analysis_result & a = analyze();
+        return (2*a.m == a.n*(a.n-1));
     }
 
     bool isEulerian() const
     {
-        for (auto v: V())
-            if (deg(v) % 2 != 0)
-                return false;
-        return isConnected();
+        return (analyze().odd == 0 && isConnected());
     }
 
     Path eulerianCycle() const
     {
         assert(isEulerian());
-        Path ans;
+        std::vector<std::pair<vid, vid>> edges;
+        std::vector<vid> tour(m() + 1);
 
-        graph copy(*this);  // make copy of this graph
+        edges.reserve(m());
+        for (vid v = 0; v < n(); ++v)
+            for (auto w: _t[v])
+                if (v < w)
+                    edges.push_back({v, w});
 
-        std::stack<Vertex> S;
+        euler_tour(n(), edges, 0, tour.data());
 
-        Vertex v = *(copy.V().begin());  // v is the first vertex in the set of vertices of copy
-        S.push(v);
-        std::cout << "start vertex: " << v << std::endl;
+        Path ans;
+        ans.reserve(tour.size());
+        for (auto v: tour)
+            ans.push_back(_names.name(v));
+        return ans;
+    }
 
-        while (!S.empty())
-        {
-            Vertex s = S.top();
-            if (copy.deg(s) != 0)
-            {
-                Vertex w = *(copy.Adj(s).begin());  // w is the first neighbors in the set of neighbors of s;
-                std::cout << "neighbor: " << w << std::endl;
-                copy.remove_edge(s, w);
 
-                S.push(w);
-            }
-            else   // s has no more neighbors
-            {
-                S.pop();
-                ans.push_back(s);
-            }
-        }
 
-        return ans;
-    }
+    // pre: none
+    // post: returns an immutable csr snapshot of this graph in which every
+    //       edge {v, w} is stored as the two arcs (v, w) and (w, v); dense ids
+    //       are the same as index()
+    csr<Vertex> freeze() const
+    {
+        std::vector<std::size_t> off;
+        std::vector<vid> adj;
 
+        _arcs(off, adj);
+        return csr<Vertex>(_names.names(), std::move(off), std::move(adj));
+    }
 
+    // pre: none
+    // post: returns a view of the arcs of freeze() by dense id, without its
+    //       table of names; the arrays are rebuilt only when the graph has
+    //       changed since the last call, and the view is invalidated by the
+    //       next change.  Like components(), it must not be called
+    //       concurrently with itself after a change
+    csr_view frozen() const
+    {
+        if (_csr_epoch != _epoch)
+        {
+            _arcs(_csr_off, _csr_adj);
+            _csr_epoch = _epoch;
+        }
+        return csr_view(n(), _csr_off.data(), _csr_adj.data());
+    }
 
     // mutator member functions
 
@@ -366,7 +413,9 @@ public:
         if (isVertex(v))
             return false;
 
-        _t[v] = VertexSet();
+        _names.intern(v);
+        _t.push_back(IdSet());
+        ++_epoch;
         return true;
     }
 
@@ -376,8 +425,42 @@ public:
     void add_edge(const Vertex &v, const Vertex &w)
     {
         assert(isVertex(v) && isVertex(w) && v != w);
-        _t[v].insert(w);
-        _t[w].insert(v);
+        vid iv = index(v), iw = index(w);
+        _t[iv].insert(iw);
+        _t[iw].insert(iv);
+        ++_epoch;
+    }
+
+    // pre: every id in e is less than n() and no pair is a loop
+    // post: adds edge {e[i].first, e[i].second} for every i; the edges are
+    //       bucketed by endpoint and each adjacency set is filled by one thread
+    void add_edges(const std::vector<std::pair<vid, vid>> & e)
+    {
+        std::vector<std::size_t> off(n() + 1, 0);
+        std::vector<vid> adj(2 * e.size());
+
+        for (auto & p: e)
+        {
+            assert(p.first < n() && p.second < n() && p.first != p.second);
+            ++off[p.first + 1];
+            ++off[p.second + 1];
+        }
+        for (vid v = 0; v < n(); ++v)
+            off[v+1] += off[v];
+
+        std::vector<std::size_t> next(off.begin(), off.end() - 1);
+        for (auto & p: e)
+        {
+            adj[next[p.first]++] = p.second;
+            adj[next[p.second]++] = p.first;
+        }
+
+        parallel_for(0, n(), [&](std::size_t v)
+        {
+            _t[v].reserve(_t[v].size() + off[v+1] - off[v]);
+            _t[v].insert(adj.begin() + off[v], adj.begin() + off[v+1]);
+        }, 64);
+        ++_epoch;
     }
 
     // pre: v and w are vertices
@@ -385,13 +468,105 @@ public:
     void remove_edge(const Vertex &v, const Vertex &w)
     {
         assert(isVertex(v) && isVertex(w));
-        _t[v].erase(w);
-        _t[w].erase(v);
+        vid iv = index(v), iw = index(w);
+        _t[iv].erase(iw);
+        _t[iw].erase(iv);
+        ++_epoch;
     }
 
 private:
 
-    std::unordered_map<Vertex, VertexSet> _t;  // Adjacency "hashmap" representation
+    symtab<Vertex> _names;        // interns vertex names to dense ids
+    std::vector<IdSet> _t;        // Adjacency "hashmap" representation; _t[i] holds the ids adjacent to id i
+
+    std::size_t _epoch;                 // bumped by every change to the graph
+    mutable std::size_t _csr_epoch;     // _epoch when _csr_off and _csr_adj were built
+    mutable std::vector<std::size_t> _csr_off;  // arrays behind frozen()
+    mutable std::vector<vid> _csr_adj;
+    mutable std::size_t _cc_epoch;      // _epoch when _cc was computed
+    mutable cc_result _cc;              // cached connected components
+    mutable std::size_t _bcc_epoch;     // _epoch when _bcc was computed
+    mutable bcc_result _bcc;            // cached result of biconnected()
+    mutable std::size_t _analysis_epoch; // _epoch when _analysis was computed
+    mutable analysis_result _analysis;  // cached result of analyze()
+
+    // post: off and adj hold the arcs of the graph in csr form, by dense id
+    void _arcs(std::vector<std::size_t> & off, std::vector<vid> & adj) const
+    {
+        off.assign(1, 0);
+        adj.clear();
+        off.reserve(n() + 1);
+        adj.reserve(2 * m());
+        for (auto & a: _t)
+        {
+            adj.insert(adj.end(), a.begin(), a.end());
+            off.push_back(adj.size());
+        }
+    }
+
+    // iterative dfs: each frame of the call stack holds a vertex and the
+    // position of the next neighbor to scan
+    void _dfs(vid source,
+              std::size_t & time,
+              std::vector<std::size_t> & pre,
+              std::vector<std::size_t> & post,
+              std::vector<std::size_t> & low,
+              std::vector<vid> & tree,
+              std::vector<vid> & back)
+    {
+        const std::size_t none = std::numeric_limits<std::size_t>::max();
+        std::vector<std::pair<vid, IdSet::const_iterator>> call;
+
+        pre[source] = time++;
+        low[source] = pre[source];
+        call.push_back({source, _t[source].begin()});
+
+        while (!call.empty())
+        {
+            vid v = call.back().first;
+            IdSet::const_iterator & it = call.back().second;
+
+            if (it != _t[v].end())
+            {
+                vid w = *it++;
+                if (pre[w] == none) // unvisited neighbor so (v, w) is a tree edge
+                {
+                    tree[w] = v;
+                    pre[w] = time++;
+                    low[w] = pre[w];
+                    call.push_back({w, _t[w].begin()});
+                }
+                else if (tree[v] != w)
+                {
+                        // (v, w) is a back edge
+                    back[v] = w;
+                    low[v] = std::min(low[v], pre[w]);
+                }
+                continue;
+            }
+
+            post[v] = time++;
+            call.pop_back();
+            if (!call.empty())
+            {
+                vid u = call.back().first;
+                low[u] = std::min(low[u], low[v]);
+            }
+        }
+
+    }
+
+    // post: translates a dense parent array to a map keyed by name
+    V2V _toV2V(const std::vector<vid> & parent) const
+    {
+        V2V ans;
+
+        for (vid i = 0; i < parent.size(); ++i)
+            if (parent[i] != NIL)
+                ans[_names.name(i)] = _names.name(parent[i]);
+
+        return ans;
+    }
 
 };
 
@@ -399,12 +574,12 @@ std::ostream & operator << (std::ostream & os, const graph & G)
 {
     os << G.n() << " " << G.m() << std::endl;
 
-    for (auto v: G.V())
+    for (auto & v: G.V())
         os << v << " ";
     os << std::endl;
 
-    for (auto v: G.V())
-        for (auto w: G.Adj(v))
+    for (auto & v: G.V())
+        for (auto & w: G.Adj(v))
             if (v < w)
                 os << v << " " << w << std::endl;
 
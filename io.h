@@ -0,0 +1,532 @@
+//
+//  io.h
+//  Header file for a memory-mapped parallel edge-list loader and a
+//  buffered writer for the "n m / vertices / edges" text format
+//
+
+#ifndef io_h
+#define io_h
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <atomic>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "graph.h"
+#include "network.h"
+#include "flownetwork.h"
+#include "parallel.h"
+
+// read-only memory map of a whole file
+class mapped_file
+{
+public:
+
+    // post: maps the file at path; isOpen() tells whether that worked
+    mapped_file(const std::string & path): _data(nullptr), _size(0)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void * p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                _data = static_cast<const char *>(p);
+                _size = st.st_size;
+                ::madvise(p, _size, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~mapped_file()
+    {
+        if (_data != nullptr)
+            ::munmap(const_cast<char *>(_data), _size);
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file & operator = (const mapped_file &) = delete;
+
+    bool isOpen() const
+    {
+        return (_data != nullptr);
+    }
+
+    const char * begin() const
+    {
+        return _data;
+    }
+
+    const char * end() const
+    {
+        return _data + _size;
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    const char * _data;
+    std::size_t _size;
+};
+
+
+// pre: [p, e) is part of a text
+// post: returns true and sets [b, te) to the next whitespace-separated
+//       token, advancing p past it; returns false if there is none
+inline bool next_token(const char * & p, const char * e, const char * & b, const char * & te)
+{
+    while (p < e && (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r'))
+        ++p;
+    if (p == e)
+        return false;
+
+    b = p;
+    while (p < e && !(*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r'))
+        ++p;
+    te = p;
+    return true;
+}
+
+// post: x is the token [b, e) read as a string
+inline bool from_token(const char * b, const char * e, std::string & x)
+{
+    x.assign(b, e);
+    return true;
+}
+
+// post: x is the token [b, e) read as a number; returns false if it is not one
+template <class T>
+typename std::enable_if<std::is_arithmetic<T>::value, bool>::type
+from_token(const char * b, const char * e, T & x)
+{
+    auto r = std::from_chars(b, e, x);
+    return (r.ec == std::errc() && r.ptr == e);
+}
+
+
+// output buffer that goes to a FILE in large writes
+class buffered_writer
+{
+public:
+
+    buffered_writer(std::FILE * f, std::size_t capacity = 1 << 20): _f(f)
+    {
+        _buf.reserve(capacity);
+    }
+
+    ~buffered_writer()
+    {
+        flush();
+    }
+
+    // post: appends raw bytes
+    void put(const char * b, std::size_t len)
+    {
+        if (_buf.size() + len > _buf.capacity())
+            flush();
+        if (len > _buf.capacity())
+            std::fwrite(b, 1, len, _f);
+        else
+            _buf.append(b, len);
+    }
+
+    void put(const std::string & x)
+    {
+        put(x.data(), x.size());
+    }
+
+    void put(char c)
+    {
+        put(&c, 1);
+    }
+
+    // post: appends the shortest text that reads back as x
+    template <class T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type
+    put(T x)
+    {
+        char tmp[64];
+        auto r = std::to_chars(tmp, tmp + sizeof(tmp), x);
+        put(tmp, r.ptr - tmp);
+    }
+
+    // post: appends x to s; tmp is scratch space for numbers
+    static void append(std::string & s, const std::string & x, char *)
+    {
+        s += x;
+    }
+
+    template <class T>
+    static typename std::enable_if<std::is_arithmetic<T>::value>::type
+    append(std::string & s, T x, char * tmp)
+    {
+        auto r = std::to_chars(tmp, tmp + 64, x);
+        s.append(tmp, r.ptr - tmp);
+    }
+
+    void flush()
+    {
+        if (!_buf.empty())
+            std::fwrite(_buf.data(), 1, _buf.size(), _f);
+        _buf.clear();
+    }
+
+private:
+    std::FILE * _f;
+    std::string _buf;
+};
+
+
+// parser for the text format read by the operator >> overloads:
+//
+//     n m
+//     v_1 v_2 ... v_n
+//     s_1 d_1 [w_1]
+//     ...
+//     s_m d_m [w_m]
+//
+// The header and the vertex list are read in order.  The edge list, which
+// must hold one edge per line as operator << writes it, is cut into chunks
+// at line breaks and the chunks are parsed by different threads.
+template <class T>
+class edge_list_reader
+{
+public:
+
+    // post: parses the file at path; ok() tells whether that worked
+    edge_list_reader(const std::string & path, bool weighted): _ok(false)
+    {
+        mapped_file f(path);
+        if (!f.isOpen())
+            return;
+
+        const char * p = f.begin(), * e = f.end(), * b, * te;
+        std::size_t n, m;
+
+        if (!next_token(p, e, b, te) || !from_token(b, te, n) ||
+            !next_token(p, e, b, te) || !from_token(b, te, m))
+            return;
+
+        vertices.resize(n);
+        for (std::size_t i = 0; i < n; ++i)
+            if (!next_token(p, e, b, te) || !from_token(b, te, vertices[i]))
+                return;
+
+        // chunk boundaries are moved forward to the next line break
+        std::size_t chunks = 4 * thread_pool::instance().size();
+        std::vector<const char *> cut(chunks + 1, e);
+        cut[0] = p;
+        for (std::size_t c = 1; c < chunks; ++c)
+        {
+            const char * q = std::max(cut[c-1], p + (e - p) * c / chunks);
+            while (q < e && *q != '\n')
+                ++q;
+            cut[c] = q;
+        }
+
+        std::vector<std::vector<T>> ends(chunks);
+        std::vector<std::vector<double>> weights(chunks);
+        std::atomic<bool> good(true);
+
+        parallel_for(0, chunks, [&](std::size_t c)
+        {
+            const char * q = cut[c], * tb, * te2;
+            T x;
+            double w;
+            while (next_token(q, cut[c+1], tb, te2))
+            {
+                if (!from_token(tb, te2, x))
+                {
+                    good = false;
+                    return;
+                }
+                ends[c].push_back(x);
+                if (weighted && ends[c].size() % 2 == 0)
+                {
+                    if (!next_token(q, cut[c+1], tb, te2) || !from_token(tb, te2, w))
+                    {
+                        good = false;
+                        return;
+                    }
+                    weights[c].push_back(w);
+                }
+            }
+            if (ends[c].size() % 2 != 0)
+                good = false;
+        }, 1);
+
+        if (!good)
+            return;
+
+        source.reserve(m);
+        target.reserve(m);
+        if (weighted)
+            weight.reserve(m);
+        for (std::size_t c = 0; c < chunks; ++c)
+        {
+            for (std::size_t i = 0; i < ends[c].size(); i += 2)
+            {
+                source.push_back(std::move(ends[c][i]));
+                target.push_back(std::move(ends[c][i+1]));
+            }
+            weight.insert(weight.end(), weights[c].begin(), weights[c].end());
+        }
+        _ok = (source.size() == m);
+    }
+
+    bool ok() const
+    {
+        return _ok;
+    }
+
+    std::vector<T> vertices;        // the vertex list, in file order
+    std::vector<T> source, target;  // edge i is (source[i], target[i])
+    std::vector<double> weight;     // weight of edge i, if weighted
+
+private:
+    bool _ok;
+};
+
+
+// post: returns true iff the file at path was read into G, which is
+//       replaced; G is unchanged on failure
+inline bool read_edge_list(const std::string & path, graph & G)
+{
+    edge_list_reader<graph::Vertex> in(path, false);
+    if (!in.ok())
+        return false;
+
+    graph ans;
+    for (auto & v: in.vertices)
+        ans.add_vertex(v);
+
+    std::vector<std::pair<vid, vid>> e(in.source.size());
+    std::atomic<bool> good(true);
+    parallel_for(0, e.size(), [&](std::size_t i)
+    {
+        if (!ans.isVertex(in.source[i]) || !ans.isVertex(in.target[i]) ||
+            in.source[i] == in.target[i])
+            good = false;
+        else
+            e[i] = {ans.index(in.source[i]), ans.index(in.target[i])};
+    });
+    if (!good)
+        return false;
+
+    ans.add_edges(e);
+    G = std::move(ans);
+    return true;
+}
+
+// post: returns true iff the file at path was read into D, which is
+//       replaced; D is unchanged on failure
+template <class T>
+bool read_edge_list(const std::string & path, digraph<T> & D)
+{
+    edge_list_reader<T> in(path, false);
+    if (!in.ok())
+        return false;
+
+    digraph<T> ans(D.isInIndexed());
+    for (auto & v: in.vertices)
+        if (!ans.isVertex(v))
+            ans.add_vertex(v);
+
+    std::vector<typename digraph<T>::DEdge> e;
+    e.reserve(in.source.size());
+    for (std::size_t i = 0; i < in.source.size(); ++i)
+    {
+        if (!ans.isVertex(in.source[i]) || !ans.isVertex(in.target[i]))
+            return false;
+        e.push_back({in.source[i], in.target[i]});
+    }
+
+    ans.add_edges(e);
+    D = std::move(ans);
+    return true;
+}
+
+// post: returns true iff the file at path was read into N, which is
+//       replaced; N is unchanged on failure
+template <class T>
+bool read_edge_list(const std::string & path, network<T> & N)
+{
+    edge_list_reader<T> in(path, true);
+    if (!in.ok())
+        return false;
+
+    network<T> ans;
+    if (N.isInIndexed())
+        ans.index_in_edges();
+    for (auto & v: in.vertices)
+        if (!ans.isVertex(v))
+            ans.add_vertex(v);
+
+    std::vector<WEdge<T>> e;
+    e.reserve(in.source.size());
+    for (std::size_t i = 0; i < in.source.size(); ++i)
+    {
+        if (!ans.isVertex(in.source[i]) || !ans.isVertex(in.target[i]))
+            return false;
+        e.push_back(WEdge<T>(in.source[i], in.target[i], in.weight[i]));
+    }
+
+    ans.add_edges(e);
+    N = std::move(ans);
+    return true;
+}
+
+// post: same as for a network; the first two vertices in the file are the
+//       source and the sink
+template <class T>
+bool read_edge_list(const std::string & path, flow_network<T> & N)
+{
+    edge_list_reader<T> in(path, true);
+    if (!in.ok() || in.vertices.size() < 2)
+        return false;
+
+    flow_network<T> ans(in.vertices[0], in.vertices[1]);
+    for (std::size_t i = 2; i < in.vertices.size(); ++i)
+        if (!ans.isVertex(in.vertices[i]))
+            ans.add_vertex(in.vertices[i]);
+
+    std::vector<WEdge<T>> e;
+    e.reserve(in.source.size());
+    for (std::size_t i = 0; i < in.source.size(); ++i)
+    {
+        if (!ans.isVertex(in.source[i]) || !ans.isVertex(in.target[i]))
+            return false;
+        e.push_back(WEdge<T>(in.source[i], in.target[i], in.weight[i]));
+    }
+
+    ans.add_edges(e);
+    N = std::move(ans);
+    return true;
+}
+
+
+// pre: order lists every vertex id of G once
+// post: writes G in the text format; threads format blocks of vertices
+//       into separate buffers which are written out in order.  If
+//       symmetric, each pair of opposite arcs is written once.
+template <class Vertex>
+bool write_edge_list(const std::string & path,
+                     const csr<Vertex> & G,
+                     const std::vector<vid> & order,
+                     bool symmetric)
+{
+    std::FILE * f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr)
+        return false;
+
+    {
+        buffered_writer out(f);
+        out.put(G.n());
+        out.put(' ');
+        out.put(symmetric ? G.m() / 2 : G.m());
+        out.put('\n');
+        for (auto v: order)
+        {
+            out.put(G.vertex(v));
+            out.put(' ');
+        }
+        out.put('\n');
+
+        const std::size_t block = 4096;
+        std::size_t blocks = (G.n() + block - 1) / block;
+        std::size_t batch = 4 * thread_pool::instance().size();
+        std::vector<std::string> text(batch);
+
+        for (std::size_t first = 0; first < blocks; first += batch)
+        {
+            std::size_t last = std::min(blocks, first + batch);
+            parallel_for(first, last, [&](std::size_t k)
+            {
+                std::string & s = text[k - first];
+                char tmp[64];
+                s.clear();
+                for (vid v = vid(k * block); v < std::min<std::size_t>(G.n(), (k + 1) * block); ++v)
+                    for (std::size_t i = G.first(v); i < G.first(v+1); ++i)
+                    {
+                        vid w = G.target(i);
+                        if (symmetric && w < v)
+                            continue;
+                        buffered_writer::append(s, G.vertex(v), tmp);
+                        s += ' ';
+                        buffered_writer::append(s, G.vertex(w), tmp);
+                        if (!symmetric && G.isWeighted() && G.m() != 0)
+                        {
+                            s += ' ';
+                            buffered_writer::append(s, G.cost(i), tmp);
+                        }
+                        s += '\n';
+                    }
+            }, 1);
+            for (std::size_t k = first; k < last; ++k)
+                out.put(text[k - first]);
+        }
+    }
+
+    return (std::fclose(f) == 0);
+}
+
+// post: returns true iff G was written to the file at path in the format
+//       read by operator >> and read_edge_list
+inline bool write_edge_list(const std::string & path, const graph & G)
+{
+    csr<graph::Vertex> S = G.freeze();
+    std::vector<vid> order(S.n());
+    for (vid v = 0; v < S.n(); ++v)
+        order[v] = v;
+    return write_edge_list(path, S, order, true);
+}
+
+template <class T>
+bool write_edge_list(const std::string & path, const digraph<T> & D)
+{
+    csr<T> S = D.freeze();
+    std::vector<vid> order(S.n());
+    for (vid v = 0; v < S.n(); ++v)
+        order[v] = v;
+    return write_edge_list(path, S, order, false);
+}
+
+template <class T>
+bool write_edge_list(const std::string & path, const network<T> & N)
+{
+    csr<T> S = N.freeze();
+    std::vector<vid> order(S.n());
+    for (vid v = 0; v < S.n(); ++v)
+        order[v] = v;
+    return write_edge_list(path, S, order, false);
+}
+
+// post: same as for a network, with the source and the sink listed first
+template <class T>
+bool write_edge_list(const std::string & path, const flow_network<T> & N)
+{
+    csr<T> S = N.freeze();
+    vid s = S.index(N.source()), t = S.index(N.sink());
+    std::vector<vid> order = {s, t};
+    for (vid v = 0; v < S.n(); ++v)
+        if (v != s && v != t)
+            order.push_back(v);
+    return write_edge_list(path, S, order, false);
+}
+
+#endif /* io_h */
@@ -10,22 +10,110 @@
 #define network_h
 #include "wedge.h"
 #include "digraph.h"
-#include <set>
+#include <vector>
+#include <algorithm>
+#include <iterator>
 #include "dary_heap.h"
-template <class T>
-class network: public digraph<T>
+#include "ds.h"
+#include "sssp.h"
+#include "p2p.h"
+#include "ch.h"
+#include "bf.h"
+#include "apsp.h"
+#include "fw.h"
+// a digraph whose edges carry weights of type double; each weight is
+// stored with its head in the out-neighbor map of its tail, so cost() and
+// the (head, weight) pairs of WAdj() need no second lookup
+template <class T, class Tables = HASH_TABLES>
+class network: public digraph<T, double, Tables>
 {
 public:
 
-    network()
+    typedef digraph<T, double, Tables> base;
+    typedef typename base::DPath DPath;
+    typedef range<typename base::OutSet::const_iterator> WAdjView;
+    typedef range<typename std::vector<WEdge<T>>::const_iterator> EdgeView;
+
+    // iterator over the edges of a network, read straight from the
+    // adjacency maps; it yields each edge as a WEdge value
+    class edge_iterator
+    {
+    public:
+
+        typedef std::forward_iterator_tag iterator_category;
+        typedef WEdge<T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef void pointer;
+        typedef WEdge<T> reference;
+
+        typedef typename base::Adjacency::const_iterator outer;
+        typedef typename base::OutSet::const_iterator inner;
+
+        edge_iterator(outer v = outer(), outer end = outer()): _v(v), _end(end)
+        {
+            if (_v != _end)
+            {
+                _w = _v->second.begin();
+                _skip();
+            }
+        }
+
+        WEdge<T> operator * () const
+        {
+            return WEdge<T>(_v->first, _w->first, _w->second);
+        }
+
+        edge_iterator & operator ++ ()
+        {
+            ++_w;
+            _skip();
+            return *this;
+        }
+
+        edge_iterator operator ++ (int)
+        {
+            edge_iterator old(*this);
+            ++*this;
+            return old;
+        }
+
+        bool operator == (const edge_iterator & other) const
+        {
+            return (_v == other._v && (_v == _end || _w == other._w));
+        }
+
+        bool operator != (const edge_iterator & other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+
+        outer _v, _end;     // the tail, and the end of the vertices
+        inner _w;           // the head and weight, in the out-neighbors of *_v
+
+        // post: moves on to the next tail with an edge left, if _w is at
+        //       the end of the out-neighbors of *_v
+        void _skip()
+        {
+            while (_v != _end && _w == _v->second.end())
+                if (++_v != _end)
+                    _w = _v->second.begin();
+        }
+    };
+
+    typedef range<edge_iterator> EdgeStream;
+
+    network(): _csr_epoch(0), _csr_queue(sssp_engine::HEAP), _rcsr_epoch(0),
+        _edges_epoch(0), _edges_sorted(false)
     {
 
     }
 
     void add_edge(const T & s, const T & d, double w)
     {
-        digraph<T>::add_edge(s, d);
-        _w[{s, d}] = w;
+        base::add_edge(s, d);
+        base::_out(s)[d] = w;
     }
 
     void add_edge(const WEdge<T> & e)
@@ -33,191 +121,405 @@ public:
         add_edge(e.s, e.d, e.w);
     }
 
-    double cost(const T & s, const T & d) const
+    // pre: every endpoint in e is a vertex
+    // post: adds every edge of e (see digraph::add_edges)
+    void add_edges(const std::vector<WEdge<T>> & e)
     {
-        assert(digraph<T>::isVertex(s) && digraph<T>::isVertex(d));
-        return _w.at({s, d});
+        base::_add_edges(e, [](const WEdge<T> & x) -> const T & { return x.s; },
+                         [](const WEdge<T> & x) -> const T & { return x.d; },
+                         [](typename base::OutSet & a, const WEdge<T> & x) { a[x.d] = x.w; });
     }
 
-    std::set<WEdge<T>> E() const
+    // pre: (s, d) is an edge
+    // post: adds dw to the weight of edge (s, d)
+    void increase_cost(const T & s, const T & d, double dw)
     {
-        std::set<WEdge<T>> ans;
-        for (auto v: digraph<T>::V())
-            for (auto w: digraph<T>::Adj(v))
-                ans.insert(WEdge<T>(v, w, cost(v, w)));
+        assert(base::isEdge(s, d));
+        base::_out(s).at(d) += dw;
+        base::_changed();
+    }
 
-        return ans;
+    double cost(const T & s, const T & d) const
+    {
+        assert(base::isVertex(s) && base::isVertex(d));
+        return base::_out(s).at(d);
     }
 
+    // pre: v is a vertex
+    // post: returns a view of the out-neighbors of v as (neighbor, weight)
+    //       pairs; the view is invalidated by any change to the out-edges of v
+    WAdjView WAdj(const T & v) const
+    {
+        assert(base::isVertex(v));
+        const typename base::OutSet & a = base::_out(v);
+        return WAdjView(a.begin(), a.end());
+    }
 
-    network Dijkstra(const T & s) const
+    // pre: none
+    // post: returns a view of every edge, in increasing order of weight
+    //       (ties by tail, then head) if sorted, and in no particular order
+    //       otherwise.  The edges are kept in one array that is made again
+    //       only when the network has changed since the last call, and
+    //       sorted once; like frozen(), it must not be called concurrently
+    //       with itself after a change.  The view is invalidated by the next
+    //       change to the network.
+    EdgeView E(bool sorted = false) const
     {
-        network ans;
-        dary_heap<WEdge<T>> H;
-        std::unordered_map<T, WEdge<T>> best;
+        if (_edges_epoch != base::epoch())
+        {
+            EdgeStream all = edges();
+            _edges.clear();
+            _edges.reserve(base::m());
+            _edges.insert(_edges.end(), all.begin(), all.end());
+            _edges_sorted = false;
+            _edges_epoch = base::epoch();
+        }
+        if (sorted && !_edges_sorted)
+        {
+            std::sort(_edges.begin(), _edges.end());
+            _edges_sorted = true;
+        }
+        return EdgeView(_edges.begin(), _edges.end());
+    }
 
-        for (auto v: digraph<T>::V())
-            ans.add_vertex(v);
+    // pre: none
+    // post: returns a view of every edge that reads them off the adjacency
+    //       maps as it goes, without making an array; it is invalidated by
+    //       any change to the edges
+    EdgeStream edges() const
+    {
+        const typename base::Adjacency & a = base::_adjacency();
+        return EdgeStream(edge_iterator(a.begin(), a.end()), edge_iterator(a.end(), a.end()));
+    }
 
-        std::unordered_set<T> out;  // out of heap, inside special vertex
 
-        best[s] = {s, s, 0};    //  dist(s, s) = 0
-        T v = s;       // vertex whose true distance was just found; initially v = s, given start vertex
-        out.insert(s);
+    // pre: none
+    // post: returns an immutable csr snapshot of this network; arc weights
+    //       are stored in an array parallel to the neighbor array
+    csr<T> freeze() const
+    {
+        return base::_freeze_weighted();
+    }
 
-        do
+    // pre: none
+    // post: returns the csr snapshot of freeze(), made again only when the
+    //       network has changed since the last call; like graph::components()
+    //       it must not be called concurrently with itself after a change.
+    //       The fringe sssp_engine picks for it, and the largest weight
+    //       that goes with it, are cached along with it.
+    //       The same holds for frozenReverse() and E(), and so for every
+    //       const query built on them: once frozen() and frozenReverse()
+    //       have been called after the last change, those queries only
+    //       read the network and may run in several threads at once.
+    const csr<T> & frozen() const
+    {
+        if (_csr_epoch != base::epoch())
         {
-            for (auto n: digraph<T>::Adj(v))
+            _csr = freeze();
+            _csr_queue = sssp_engine::choose(_csr);
+            _csr_epoch = base::epoch();
+        }
+        return _csr;
+    }
+
+    // pre: s is a vertex and no weight is negative
+    // post: returns the shortest path tree from s, over all vertices
+    network Dijkstra(const T & s) const
+    {
+        const csr<T> & G = frozen();
+        sssp_engine E(G, _csr_queue);
+        network ans;
+
+        E.run(G.index(s));
+        for (vid v = 0; v < G.n(); ++v)
+            ans.add_vertex(G.vertex(v));
+        for (auto v: E.touched())
+            if (E.parent(v) != v)
             {
-                if (out.count(n) != 0)
-                    continue;
-
-                WEdge<T> fringe({v, n, best[v].w+cost(v,n)});
-
-                if (best.count(n) == 0)
-                {
-                    H.push(fringe);
-                    best[n] = fringe;
-                }
-                else if (best[n].w > fringe.w)
-                {
-                    best[n] = fringe;
-                    H.decrease_key(best[n], fringe);
-                }
+                const T & p = G.vertex(E.parent(v));
+                ans.add_edge(p, G.vertex(v), cost(p, G.vertex(v)));
             }
 
-            WEdge<T> m = H.min();
-            H.pop_min();
-            ans.add_edge(m.s, m.d, cost(m.s, m.d));
-            v = m.d;
-            out.insert(v);
-        } while (!H.empty());
+        return ans;
+    }
+
+    // pre: none
+    // post: returns the reverse of frozen(), with the same ids and weights;
+    //       it is cached in the same way
+    const csr<T> & frozenReverse() const
+    {
+        if (_rcsr_epoch != base::epoch())
+        {
+            _rcsr = frozen().transpose();
+            _rcsr_epoch = base::epoch();
+        }
+        return _rcsr;
+    }
 
+    // pre: s and t are vertices and no weight is negative
+    // post: returns the length of a shortest path from s to t, or infinity
+    //       if there is none (see bidirectionalDijkstra)
+    double distance(const T & s, const T & t) const
+    {
+        double d;
+        bidirectionalDijkstra(s, t, d);
+        return d;
+    }
 
+    // pre: as for bidirectionalDijkstra with an engine
+    // post: same as above, with the search run in E
+    double distance(const T & s, const T & t, bidirectional_engine & E) const
+    {
+        double d;
+        bidirectionalDijkstra(s, t, d, E);
+        return d;
+    }
 
+    // pre: s and t are vertices and no weight is negative
+    // post: returns the vertices of a shortest path from s to t, or an
+    //       empty path if there is none
+    DPath shortestPath(const T & s, const T & t) const
+    {
+        double d;
+        return bidirectionalDijkstra(s, t, d);
+    }
 
-    return ans;
+    // pre: s and t are vertices and no weight is negative
+    // post: returns the vertices of a shortest path from s to t and sets d
+    //       to its length; if there is none, returns an empty path and sets
+    //       d to infinity.  The search grows from s forward and from t
+    //       backward until the two meet.  Its workspace is O(n) to make;
+    //       for many queries, pass an engine to the overload below.
+    DPath bidirectionalDijkstra(const T & s, const T & t, double & d) const
+    {
+        bidirectional_engine E(frozen(), frozenReverse());
+        return bidirectionalDijkstra(s, t, d, E);
     }
 
+    // pre: s and t are vertices, no weight is negative, and E is
+    //      bidirectional_engine(frozen(), frozenReverse()) made since the
+    //      last change to the network
+    // post: same as above, but the search runs in E, which resets only what
+    //       its last query touched.  Each thread answering queries should
+    //       own its engine.
+    DPath bidirectionalDijkstra(const T & s, const T & t, double & d, bidirectional_engine & E) const
+    {
+        const csr<T> & G = frozen();
+        DPath ans;
 
-    std::unordered_map<T, T> Bellman_Ford(const T & s, std::unordered_map<T, double> &d)
+        d = E.run(G.index(s), G.index(t));
+        for (auto v: E.path())
+            ans.push_back(G.vertex(v));
+        return ans;
+    }
+
+    // pre: every source and target is a vertex and no weight is negative
+    // post: returns the distances from every source to every target, row by
+    //       row: entry i * targets.size() + j is the distance from sources[i]
+    //       to targets[j], or infinity if there is none.  The searches run
+    //       in parallel (see ::distance_matrix).
+    std::vector<double> distance_matrix(const std::vector<T> & sources,
+                                        const std::vector<T> & targets) const
     {
-        std::unordered_map<T, T> parent;  // (parent(v), v) is last edge on shortest path from s to v
-        std::unordered_map<T, double> D;  // shortest distance from s to  v
+        const csr<T> & G = frozen();
+        std::vector<vid> s(sources.size()), t(targets.size());
+        std::vector<double> ans(s.size() * t.size());
+
+        for (std::size_t i = 0; i < s.size(); ++i)
+            s[i] = G.index(sources[i]);
+        for (std::size_t j = 0; j < t.size(); ++j)
+            t[j] = G.index(targets[j]);
+        ::distance_matrix(G, s, t, ans.data(), _csr_queue);
+        return ans;
+    }
+
+    // pre: no weight is negative
+    // post: returns the contraction hierarchy of this network, whose vertex
+    //       ids are those of frozen(); it answers queries through ch_engine
+    //       and stays valid only as long as the network does not change
+    contraction_hierarchy contract() const
+    {
+        return contraction_hierarchy(frozen());
+    }
+
+    // pre: s and t are vertices, no weight is negative, and h(v) is at
+    //      most the distance from v to t for every vertex v
+    // post: same as bidirectionalDijkstra, by A* search guided by h; for
+    //       instance, h can be the straight-line distance to t when the
+    //       vertices have coordinates and weights are road lengths
+    template <class Heuristic>
+    DPath Astar(const T & s, const T & t, Heuristic h, double & d) const
+    {
+        astar_engine E(frozen());
+        return Astar(s, t, h, d, E);
+    }
+
+    // pre: as above, and E is astar_engine(frozen()) made since the last
+    //      change to the network
+    // post: same as above, with the search run in E (see
+    //       bidirectionalDijkstra)
+    template <class Heuristic>
+    DPath Astar(const T & s, const T & t, Heuristic h, double & d, astar_engine & E) const
+    {
+        const csr<T> & G = frozen();
+        DPath ans;
+
+        d = E.run(G.index(s), G.index(t), [&](vid v) { return h(G.vertex(v)); });
+        for (auto v: E.path(G.index(t)))
+            ans.push_back(G.vertex(v));
+        return ans;
+    }
 
-        for (auto v: digraph<T>::V())
-            d[v] = std::numeric_limits<double>::infinity();
 
-        d[s] = 0;
+    // pre: s is a vertex and no negative cycle is reachable from s
+    // post: d[v] is the distance from s to v (infinity if v is not reached)
+    //       for every vertex v; returns the shortest path tree as a map from
+    //       each reached vertex other than s to its parent (see bf_engine)
+    std::unordered_map<T, T> Bellman_Ford(const T & s, std::unordered_map<T, double> &d)
+    {
+        const csr<T> & G = frozen();
+        bf_engine E(G);
+        std::unordered_map<T, T> parent;  // (parent(v), v) is last edge on shortest path from s to v
 
-        for (std::size_t k = 1; k < digraph<T>::n(); ++k)
+        E.run(G.index(s));
+        d.reserve(G.n());
+        for (vid v = 0; v < G.n(); ++v)
         {
-            D = d;
-            //for (auto e: digraph<T>::E())
-            for (auto v: digraph<T>::V())
-            {
-                for (auto n: digraph<T>::Adj(v))
-                {
-                    double temp = d[v] + cost(v, n);
-                    if (D[n] > temp)  // found better route
-                    {
-                        D[n] = temp;
-                        parent[n] = v;
-                    }
-                }
-            }
-            d = D;
+            d[G.vertex(v)] = E.dist(v);
+            if (E.parent(v) != NIL && E.parent(v) != v)
+                parent[G.vertex(v)] = G.vertex(E.parent(v));
         }
+        return parent;
+    }
+
+    // pre: none
+    // post: returns false iff the network has a negative cycle; otherwise
+    //       d holds n() * n() distances, row by row, where entry
+    //       i * n() + j is the distance from frozen().vertex(i) to
+    //       frozen().vertex(j), or infinity if there is none.  Weights may
+    //       be negative (see johnson_engine); the Dijkstra searches run in
+    //       parallel.
+    bool Johnson(std::vector<double> & d) const
+    {
+        const csr<T> & G = frozen();
+        johnson_engine E(G);
+
+        if (!E.ok())
+            return false;
+        d.resize(G.n() * G.n());
+        E.run(d.data());
+        return true;
+    }
+
+    // pre: none
+    // post: returns the dense adjacency matrix of this network, whose
+    //       vertex ids are those of frozen(); for dense networks its
+    //       floyd_warshall() is the fastest way to all distances
+    adjacency_matrix matrix() const
+    {
+        return adjacency_matrix(frozen());
+    }
+
+    // pre: s is a vertex
+    // post: returns true iff a negative cycle is reachable from s, in which
+    //       case cycle holds its vertices in order (an edge from the last
+    //       back to the first closes it) and weight is its total weight
+    bool negativeCycle(const T & s, DPath & cycle, double & weight) const
+    {
+        const csr<T> & G = frozen();
+        bf_engine E(G);
+        std::vector<vid> C;
+
+        cycle.clear();
+        if (!E.negative_cycle(G.index(s), C, weight))
+            return false;
+        for (auto v: C)
+            cycle.push_back(G.vertex(v));
+        return true;
+    }
+
+    // post: same, for a negative cycle anywhere in the network
+    bool negativeCycle(DPath & cycle, double & weight) const
+    {
+        const csr<T> & G = frozen();
+        bf_engine E(G);
+        std::vector<vid> C;
+
+        cycle.clear();
+        if (!E.negative_cycle(C, weight))
+            return false;
+        for (auto v: C)
+            cycle.push_back(G.vertex(v));
+        return true;
+    }
+
+    // pre: none
+    // post: returns a minimum spanning forest of this network with every
+    //       edge taken as undirected, over all vertices (Kruskal's
+    //       algorithm on the weight-sorted edges of E(true))
+    network Kruskal() const
+    {
+        ds<T, Tables> S;
+        network ans;
 
-        network<T> ans;
-        for (auto v: digraph<T>::V())
+        for (auto & v: base::V())
+        {
+            S.make_set(v);
             ans.add_vertex(v);
+        }
+        for (auto & e: E(true))
+            if (S.join(e.s, e.d))
+                ans.add_edge(e.s, e.d, e.w);
 
-        for (auto e: parent)
-            ans.add_edge(e.second, e.first, cost(e.second, e.first));
-        
-        return parent;
+        return ans;
     }
-    
+
+    // pre: s is a vertex
+    // post: returns the vertices of a negative cycle reachable from s, in
+    //       order, or an empty vector if there is none
     std::vector<int> Bellman_Ford_2(const T & s)
     {
-        std::unordered_map<T, T> parent;  // (parent(v), v) is last edge on shortest path from s to v
-        std::unordered_map<T, double> d, D;  // shortest distance from s to  v
-        for (auto v: digraph<T>::V())
-            d[v] = std::numeric_limits<double>::infinity();
-
-            d[s] = 0;
-
-           for (std::size_t k = 1; k < digraph<T>::n(); ++k)
-           {
-               D = d;
-               for (auto v: digraph<T>::V())
-               {
-                   for (auto n: digraph<T>::Adj(v))
-                   {
-                       double temp = d[v] + cost(v, n);
-                       if (D[n] > temp)  // found better route
-                       {
-                           D[n] = temp;
-                           parent[n] = v;
-                       }
-                   }
-               }
-               d = D;
-           }
-           
-           int changed_vertex=0;
-           int changed_parent=0;
-           std::vector<int> path;
-           //perform one extra loop and check for changes indicating a negative cycle
-           for (auto v: digraph<T>::V())
-           {
-               for (auto n: digraph<T>::Adj(v))
-               {
-                   double temp = d[v] + cost(v, n);
-                   if (D[n] > temp)  // found better route
-                   {
-                       //something happened--negative path
-                       changed_vertex=n;
-                       changed_parent= v;
-                       //create path from vertex to vertex parent
-                       while(changed_parent != changed_vertex){
-                            path.push_back(changed_parent);
-                            changed_parent= parent[changed_parent];
-                       }
-                       path.push_back(changed_vertex);
-                       std::reverse(path.begin(),path.end());
-                       
-                       return path;
-                   }
-               }
-           }
-           
-        return std::vector<int> ();
-       }
+        const csr<T> & G = frozen();
+        bf_engine E(G);
+        std::vector<vid> C;
+        std::vector<int> path;
+        double weight;
+
+        if (E.negative_cycle(G.index(s), C, weight))
+            for (auto v: C)
+                path.push_back(G.vertex(v));
+        return path;
+    }
 
 private:
 
-    std::unordered_map<Edge<T>, double> _w;  // maps an edge to its weight
+    mutable std::size_t _csr_epoch;          // epoch() when _csr was made
+    mutable csr<T> _csr;                     // cached result of freeze()
+    mutable sssp_engine::fringe _csr_queue;  // sssp_engine::choose(_csr)
+    mutable std::size_t _rcsr_epoch;
+    mutable csr<T> _rcsr;                    // cached result of frozenReverse()
+    mutable std::size_t _edges_epoch;        // epoch() when _edges was made
+    mutable bool _edges_sorted;              // true iff _edges is sorted by weight
+    mutable std::vector<WEdge<T>> _edges;    // cached edges for E()
 };
 
-template <class T>
-std::ostream & operator << (std::ostream & os, const network<T> & N)
+template <class T, class Tables>
+std::ostream & operator << (std::ostream & os, const network<T, Tables> & N)
 {
     os << N.n() << " " << N.m() << std::endl;
-    for (auto v: N.V())
+    for (auto & v: N.V())
         os << v << " ";
     os << std::endl;
 
-    for (auto v: N.V())
-        for (auto w: N.Adj(v))
-            os << v << " " << w << " " << N.cost(v, w) << std::endl;
+    for (auto & v: N.V())
+        for (auto & x: N.WAdj(v))
+            os << v << " " << x.first << " " << x.second << std::endl;
 
     return os;
 }
 
-template <class T>
-std::istream & operator >> (std::istream & is, network<T> & N)
+template <class T, class Tables>
+std::istream & operator >> (std::istream & is, network<T, Tables> & N)
 {
     std::size_t n, m;
     T s, d;
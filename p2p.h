@@ -0,0 +1,244 @@
+//
+//  p2p.h
+//  Header file for point-to-point shortest paths: bidirectional Dijkstra
+//  and A*
+//
+
+#ifndef p2p_h
+#define p2p_h
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+#include "csr.h"
+#include "dary_heap.h"
+
+// Dijkstra's algorithm from s on G and from t on its reverse R at once,
+// always advancing the side whose fringe has the smaller key.  mu is the
+// length of the shortest s-t path seen so far, through some vertex reached
+// from both sides; once the two fringe minima add up to at least mu no
+// shorter path is left, so the search stops.  Workspaces are reset in time
+// proportional to what the last query touched.
+class bidirectional_engine
+{
+public:
+
+    // pre: G and R are weighted with the same ids, R is the reverse of G,
+    //      no weight is negative, and both outlive the engine
+    bidirectional_engine(const csr_view & G, const csr_view & R): _mu(0), _meet(NIL)
+    {
+        _side[0].init(G);
+        _side[1].init(R);
+    }
+
+    // pre: s, t < G.n()
+    // post: returns the distance from s to t, or infinity if there is none
+    double run(vid s, vid t)
+    {
+        const double inf = std::numeric_limits<double>::infinity();
+        _side[0].reset();
+        _side[1].reset();
+        _mu = inf;
+        _meet = NIL;
+
+        _side[0].start(s);
+        _side[1].start(t);
+        _update(s);
+
+        while (!_side[0].H.empty() && !_side[1].H.empty())
+        {
+            if (_side[0].H.min_key() + _side[1].H.min_key() >= _mu)
+                break;
+
+            int k = (_side[0].H.min_key() <= _side[1].H.min_key()) ? 0 : 1;
+            search & S = _side[k];
+            vid v = vid(S.H.min());
+            S.H.pop_min();
+
+            for (std::size_t i = S.G->first(v); i < S.G->first(v+1); ++i)
+            {
+                vid w = S.G->target(i);
+                double temp = S.dist[v] + S.G->cost(i);
+                if (temp < S.dist[w])   // found better route
+                {
+                    if (S.parent[w] == NIL)
+                        S.touched.push_back(w);
+                    S.dist[w] = temp;
+                    S.parent[w] = v;
+                    S.H.push_or_decrease(w, temp);
+                    _update(w);
+                }
+            }
+        }
+
+        _side[0].H.clear();
+        _side[1].H.clear();
+        return _mu;
+    }
+
+    // post: returns the ids on the path found by the last run, from s to
+    //       t, or an empty vector if t was not reached
+    std::vector<vid> path() const
+    {
+        std::vector<vid> ans;
+        if (_meet == NIL)
+            return ans;
+
+        for (vid v = _meet; ; v = _side[0].parent[v])
+        {
+            ans.push_back(v);
+            if (_side[0].parent[v] == v)
+                break;
+        }
+        std::reverse(ans.begin(), ans.end());
+        for (vid v = _meet; _side[1].parent[v] != v; )
+        {
+            v = _side[1].parent[v];
+            ans.push_back(v);
+        }
+        return ans;
+    }
+
+private:
+
+    // the state of one direction of the search
+    struct search
+    {
+        const csr_view * G;
+        std::vector<double> dist;
+        std::vector<vid> parent;
+        std::vector<vid> touched;
+        indexed_heap<double> H;
+
+        void init(const csr_view & g)
+        {
+            G = &g;
+            dist.assign(g.n(), std::numeric_limits<double>::infinity());
+            parent.assign(g.n(), NIL);
+            H.resize(g.n());
+        }
+
+        void start(vid s)
+        {
+            touched.push_back(s);
+            dist[s] = 0;
+            parent[s] = s;
+            H.push(s, 0);
+        }
+
+        void reset()
+        {
+            for (auto v: touched)
+            {
+                dist[v] = std::numeric_limits<double>::infinity();
+                parent[v] = NIL;
+            }
+            touched.clear();
+        }
+    };
+
+    search _side[2];            // 0 searches G from s, 1 searches R from t
+    double _mu;
+    vid _meet;                  // vertex on the path of length _mu
+
+    void _update(vid w)
+    {
+        double d = _side[0].dist[w] + _side[1].dist[w];
+        if (d < _mu)
+        {
+            _mu = d;
+            _meet = w;
+        }
+    }
+};
+
+
+// A* search: Dijkstra's algorithm on the keys dist(v) + h(v), where h(v)
+// never overestimates the distance from v to the target.  A vertex whose
+// distance drops after it was settled goes back into the fringe, so h only
+// has to be admissible; with a consistent h that never happens.  The search
+// stops when the target leaves the fringe, since every other fringe key is
+// then at least its distance.
+class astar_engine
+{
+public:
+
+    // pre: G is weighted, no weight is negative and G outlives the engine
+    astar_engine(const csr_view & G): _G(G), _source(NIL),
+        _dist(G.n(), std::numeric_limits<double>::infinity()), _parent(G.n(), NIL), _H(G.n())
+    {
+
+    }
+
+    // pre: s, t < G.n(); h(v) is at most the distance from v to t
+    // post: returns the distance from s to t, or infinity if there is none
+    template <class Heuristic>
+    double run(vid s, vid t, Heuristic h)
+    {
+        assert(s < _G.n() && t < _G.n());
+        for (auto v: _touched)
+        {
+            _dist[v] = std::numeric_limits<double>::infinity();
+            _parent[v] = NIL;
+        }
+        _touched.clear();
+
+        _source = s;
+        _touched.push_back(s);
+        _dist[s] = 0;
+        _parent[s] = s;
+        _H.push(s, h(s));
+
+        while (!_H.empty())
+        {
+            vid v = vid(_H.min());
+            _H.pop_min();
+            if (v == t)
+                break;
+
+            for (std::size_t i = _G.first(v); i < _G.first(v+1); ++i)
+            {
+                vid w = _G.target(i);
+                double temp = _dist[v] + _G.cost(i);
+                if (temp < _dist[w])    // found better route
+                {
+                    if (_parent[w] == NIL)
+                        _touched.push_back(w);
+                    _dist[w] = temp;
+                    _parent[w] = v;
+                    _H.push_or_decrease(w, temp + h(w));
+                }
+            }
+        }
+
+        _H.clear();
+        return _dist[t];
+    }
+
+    // post: returns the ids on the path found from the source to t, or an
+    //       empty vector if t was not reached
+    std::vector<vid> path(vid t) const
+    {
+        std::vector<vid> ans;
+        if (_parent[t] == NIL)
+            return ans;
+
+        for (vid v = t; v != _source; v = _parent[v])
+            ans.push_back(v);
+        ans.push_back(_source);
+        std::reverse(ans.begin(), ans.end());
+        return ans;
+    }
+
+private:
+
+    const csr_view & _G;
+    vid _source;
+    std::vector<double> _dist;
+    std::vector<vid> _parent;
+    std::vector<vid> _touched;
+    indexed_heap<double> _H;        // fringe, by dist(v) + h(v)
+};
+
+#endif /* p2p_h */
@@ -10,8 +10,9 @@
 #define ph_h
 #include <vector>
 #include <unordered_map>
+#include "flat_hash.h"
 
-template <class T>
+template <class T, class Tables = HASH_TABLES>
 class ph
 {
 public:
@@ -133,7 +134,7 @@ public:
 
 private:
     node * head;               // points to the root
-    std::unordered_map<T, node *> _l;  //maps key to node containing it
+    typename Tables::template map<T, node *> _l;  //maps key to node containing it
     
     
     //merges two pairing heaps
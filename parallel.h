@@ -0,0 +1,197 @@
+//
+//  parallel.h
+//  Header file for a small thread pool and parallel loops
+//
+
+#ifndef parallel_h
+#define parallel_h
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+// number of threads in the shared pool; 0 means one per hardware thread
+#ifndef PARALLEL_THREADS
+#define PARALLEL_THREADS 0
+#endif
+
+// a fixed set of worker threads that run one job at a time; a job is a
+// function f that is called as f(t) for every t = 0, ..., size()-1, the
+// calling thread acting as worker 0
+class thread_pool
+{
+public:
+
+    // post: returns the pool shared by the whole library; its size is
+    //       PARALLEL_THREADS, or the number of hardware threads if that is 0
+    static thread_pool & instance()
+    {
+        static thread_pool pool(PARALLEL_THREADS != 0 ? PARALLEL_THREADS :
+                                std::max<std::size_t>(1, std::thread::hardware_concurrency()));
+        return pool;
+    }
+
+    explicit thread_pool(std::size_t n): _size(n), _job(nullptr), _generation(0), _pending(0), _stop(false)
+    {
+        for (std::size_t t = 1; t < _size; ++t)
+            _workers.emplace_back([this, t] { _work(t); });
+    }
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_m);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto & w: _workers)
+            w.join();
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool & operator = (const thread_pool &) = delete;
+
+    // pre: none
+    // post: returns the number of workers, including the calling thread
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    // pre: none
+    // post: f(t) has returned for every t = 0, ..., size()-1; a job started
+    //       from inside another job runs all of its f(t) on the calling thread
+    void run(const std::function<void(std::size_t)> & f)
+    {
+        if (_size == 1 || _inside())
+        {
+            for (std::size_t t = 0; t < _size; ++t)
+                f(t);
+            return;
+        }
+
+        std::lock_guard<std::mutex> serial(_busy);   // one job at a time
+        {
+            std::lock_guard<std::mutex> lock(_m);
+            _job = &f;
+            _pending = _size - 1;
+            ++_generation;
+        }
+        _wake.notify_all();
+
+        _inside() = true;
+        f(0);
+        _inside() = false;
+
+        std::unique_lock<std::mutex> lock(_m);
+        _done.wait(lock, [this] { return _pending == 0; });
+        _job = nullptr;
+    }
+
+private:
+
+    std::size_t _size;
+    std::vector<std::thread> _workers;
+    std::mutex _m, _busy;
+    std::condition_variable _wake, _done;
+    const std::function<void(std::size_t)> * _job;
+    std::size_t _generation, _pending;
+    bool _stop;
+
+    static bool & _inside()
+    {
+        thread_local bool inside = false;
+        return inside;
+    }
+
+    void _work(std::size_t t)
+    {
+        std::size_t seen = 0;
+        _inside() = true;
+        for (;;)
+        {
+            const std::function<void(std::size_t)> * job;
+            {
+                std::unique_lock<std::mutex> lock(_m);
+                _wake.wait(lock, [this, seen] { return _stop || _generation != seen; });
+                if (_stop)
+                    return;
+                seen = _generation;
+                job = _job;
+            }
+
+            (*job)(t);
+
+            std::lock_guard<std::mutex> lock(_m);
+            if (--_pending == 0)
+                _done.notify_one();
+        }
+    }
+};
+
+
+// pre: f can be called concurrently for different indices
+// post: f(i) has been called for every i in [b, e); indices are handed out
+//       in chunks of grain, and ranges of at most grain run serially
+template <class F>
+void parallel_for(std::size_t b, std::size_t e, F f, std::size_t grain = 1024)
+{
+    thread_pool & pool = thread_pool::instance();
+    if (e <= b + grain || pool.size() == 1)
+    {
+        for (std::size_t i = b; i < e; ++i)
+            f(i);
+        return;
+    }
+
+    std::atomic<std::size_t> next(b);
+    pool.run([&](std::size_t)
+    {
+        for (;;)
+        {
+            std::size_t lo = next.fetch_add(grain);
+            if (lo >= e)
+                return;
+            std::size_t hi = std::min(e, lo + grain);
+            for (std::size_t i = lo; i < hi; ++i)
+                f(i);
+        }
+    });
+}
+
+// pre: f can be called concurrently for different indices
+// post: same as parallel_for, but f is called as f(i, t) where t < the
+//       pool size is the worker running it, so f can use scratch space
+//       kept per worker; ranges of at most grain run on worker 0
+template <class F>
+void parallel_for_workers(std::size_t b, std::size_t e, F f, std::size_t grain = 1024)
+{
+    thread_pool & pool = thread_pool::instance();
+    if (e <= b + grain || pool.size() == 1)
+    {
+        for (std::size_t i = b; i < e; ++i)
+            f(i, 0);
+        return;
+    }
+
+    std::atomic<std::size_t> next(b);
+    pool.run([&](std::size_t t)
+    {
+        for (;;)
+        {
+            std::size_t lo = next.fetch_add(grain);
+            if (lo >= e)
+                return;
+            std::size_t hi = std::min(e, lo + grain);
+            for (std::size_t i = lo; i < hi; ++i)
+                f(i, t);
+        }
+    });
+}
+
+#endif /* parallel_h */
@@ -0,0 +1,169 @@
+//
+//  radix_heap.h
+//  Header file for monotone integer priority queues: a radix heap and
+//  Dial's bucket queue
+//
+
+#ifndef radix_heap_h
+#define radix_heap_h
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+
+// Both queues hold (key, id) pairs with unsigned integer keys and are
+// monotone: a key pushed must not be smaller than the last key popped,
+// which is always so for the fringe of Dijkstra's algorithm.  Neither
+// supports decrease_key; pushing an id again with a smaller key leaves a
+// stale entry behind, which the caller skips when it is popped.
+
+
+// radix heap: entry (k, i) lives in bucket 0 if k equals the last key
+// popped, and otherwise in bucket b where b-1 is the highest bit in which k
+// differs from it.  Popping from an empty bucket 0 moves the smallest
+// non-empty bucket down, and each entry can move down at most 64 times.
+class radix_heap
+{
+public:
+
+    typedef std::pair<std::uint64_t, std::uint32_t> entry;
+
+    radix_heap(): _last(0), _n(0)
+    {
+
+    }
+
+    bool empty() const
+    {
+        return (_n == 0);
+    }
+
+    std::size_t size() const
+    {
+        return _n;
+    }
+
+    // pre: k is not smaller than the last key popped
+    void push(std::uint64_t k, std::uint32_t i)
+    {
+        assert(k >= _last);
+        _b[_bucket(k)].push_back({k, i});
+        ++_n;
+    }
+
+    // post: returns false if empty; otherwise removes an entry with the
+    //       smallest key, sets k and i to it and returns true
+    bool pop(std::uint64_t & k, std::uint32_t & i)
+    {
+        if (_n == 0)
+            return false;
+
+        if (_b[0].empty())
+        {
+            std::size_t j = 1;
+            while (_b[j].empty())
+                ++j;
+
+            std::uint64_t m = _b[j][0].first;
+            for (auto & e: _b[j])
+                m = std::min(m, e.first);
+
+            _last = m;
+            for (auto & e: _b[j])
+                _b[_bucket(e.first)].push_back(e);
+            _b[j].clear();
+        }
+
+        k = _b[0].back().first;
+        i = _b[0].back().second;
+        _b[0].pop_back();
+        --_n;
+        return true;
+    }
+
+    // post: the heap is empty and accepts any key again
+    void clear()
+    {
+        for (auto & b: _b)
+            b.clear();
+        _last = 0;
+        _n = 0;
+    }
+
+private:
+
+    std::vector<entry> _b[65];
+    std::uint64_t _last;        // last key popped
+    std::size_t _n;
+
+    std::size_t _bucket(std::uint64_t k) const
+    {
+        return (k == _last) ? 0 : 64 - __builtin_clzll(k ^ _last);
+    }
+};
+
+
+// Dial's bucket queue for keys that exceed the last key popped by at most
+// c: c+1 buckets are used in a circle, and bucket k % (c+1) holds key k
+class bucket_queue
+{
+public:
+
+    // pre: every key pushed is at most c larger than the last key popped
+    bucket_queue(std::uint64_t c = 0): _b(c + 1), _cur(0), _n(0)
+    {
+
+    }
+
+    bool empty() const
+    {
+        return (_n == 0);
+    }
+
+    std::size_t size() const
+    {
+        return _n;
+    }
+
+    void push(std::uint64_t k, std::uint32_t i)
+    {
+        assert(k >= _cur && k - _cur < _b.size());
+        _b[k % _b.size()].push_back(i);
+        ++_n;
+    }
+
+    // post: same as radix_heap::pop
+    bool pop(std::uint64_t & k, std::uint32_t & i)
+    {
+        if (_n == 0)
+            return false;
+
+        while (_b[_cur % _b.size()].empty())
+            ++_cur;
+
+        std::vector<std::uint32_t> & b = _b[_cur % _b.size()];
+        k = _cur;
+        i = b.back();
+        b.pop_back();
+        --_n;
+        return true;
+    }
+
+    void clear()
+    {
+        for (auto & b: _b)
+            b.clear();
+        _cur = 0;
+        _n = 0;
+    }
+
+private:
+
+    std::vector<std::vector<std::uint32_t>> _b;
+    std::uint64_t _cur;         // smallest key that may still be in the queue
+    std::size_t _n;
+};
+
+#endif /* radix_heap_h */
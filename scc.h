@@ -0,0 +1,480 @@
+//
+//  scc.h
+//  Header file for strongly connected component algorithms on csr snapshots
+//
+
+#ifndef scc_h
+#define scc_h
+
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <cassert>
+#include "csr.h"
+#include "parallel.h"
+
+// comp[v] is the component of vertex v; components are 0, ..., count-1
+struct scc_result
+{
+    std::vector<vid> comp;
+    std::size_t count;
+
+    scc_result(std::size_t n = 0): comp(n, NIL), count(0)
+    {
+
+    }
+};
+
+
+// strongly connected components of a csr snapshot G whose reverse is R;
+// none of the algorithms recurse, so the depth of G does not matter
+class scc_engine
+{
+public:
+
+    // pre: R is the reverse of G; both outlive the engine
+    scc_engine(const csr_view & G, const csr_view & R): _G(G), _R(R)
+    {
+        assert(G.n() == R.n() && G.m() == R.m());
+    }
+
+    // Pearce's space-efficient version of Tarjan's algorithm with an
+    // explicit call stack; components come out in reverse topological order
+    scc_result tarjan() const
+    {
+        std::vector<char> all(_G.n(), 1);
+        scc_result ans(_G.n());
+        _pearce(all, ans);
+        return ans;
+    }
+
+    // Kosaraju's algorithm: vertices are ordered by decreasing finishing
+    // time of a dfs on R, then G is searched in that order
+    scc_result kosaraju() const
+    {
+        std::size_t n = _G.n();
+        scc_result ans(n);
+        std::vector<vid> order;
+        std::vector<char> visited(n, 0);
+        std::vector<std::pair<vid, std::size_t>> call;   // (vertex, next arc)
+
+        order.reserve(n);
+        for (vid r = 0; r < n; ++r)
+        {
+            if (visited[r])
+                continue;
+            visited[r] = 1;
+            call.push_back({r, _R.first(r)});
+            while (!call.empty())
+            {
+                vid v = call.back().first;
+                std::size_t & i = call.back().second;
+                if (i < _R.first(v+1))
+                {
+                    vid w = _R.target(i++);
+                    if (!visited[w])
+                    {
+                        visited[w] = 1;
+                        call.push_back({w, _R.first(w)});
+                    }
+                }
+                else
+                {
+                    order.push_back(v);
+                    call.pop_back();
+                }
+            }
+        }
+
+        std::vector<vid> S;
+        for (std::size_t k = n; k-- > 0; )
+        {
+            vid r = order[k];
+            if (ans.comp[r] != NIL)
+                continue;
+            ans.comp[r] = ans.count;
+            S.push_back(r);
+            while (!S.empty())
+            {
+                vid v = S.back();
+                S.pop_back();
+                for (auto w: _G.Adj(v))
+                    if (ans.comp[w] == NIL)
+                    {
+                        ans.comp[w] = ans.count;
+                        S.push_back(w);
+                    }
+            }
+            ++ans.count;
+        }
+        return ans;
+    }
+
+    // multithreaded components: trim vertices with no in- or out-arcs,
+    // peel off the component of a high-degree pivot with one
+    // forward-backward search, then repeatedly propagate the largest
+    // reaching vertex id forward (coloring) and collect each color's
+    // component with a backward search from its root; a small remainder
+    // is finished with tarjan(), which also does all the work when the
+    // thread pool has a single thread
+    scc_result parallel(std::size_t serial_below = 4096) const
+    {
+        if (thread_pool::instance().size() == 1)
+            return tarjan();
+
+        std::size_t n = _G.n();
+        scc_result ans(n);
+        std::vector<char> active(n, 1);
+        std::atomic<vid> next(0);
+        std::size_t left = n;
+
+        // in[v] and out[v] count the arcs between v and other active
+        // vertices; a vertex is queued for trimming once one of them is 0
+        std::vector<std::atomic<std::size_t>> in(n), out(n);
+        std::vector<std::atomic<char>> queued(n);
+        std::vector<vid> work;
+        parallel_for(0, n, [&](std::size_t v)
+        {
+            std::size_t i = 0, o = 0;
+            for (auto w: _G.Adj(vid(v)))
+                o += w != v;
+            for (auto w: _R.Adj(vid(v)))
+                i += w != v;
+            in[v].store(i, std::memory_order_relaxed);
+            out[v].store(o, std::memory_order_relaxed);
+            queued[v].store(i == 0 || o == 0, std::memory_order_relaxed);
+        }, 256);
+        for (vid v = 0; v < n; ++v)
+            if (queued[v].load(std::memory_order_relaxed))
+                work.push_back(v);
+
+        trim_state T{active, in, out, queued, ans, next};
+        left -= _trim(T, work);
+
+        if (left > 0)
+        {
+            // the pivot maximizes indeg*outdeg, so it is likely in the giant component
+            vid pivot = NIL;
+            std::size_t best = 0;
+            for (vid v = 0; v < n; ++v)
+                if (active[v] && (pivot == NIL || _G.outdeg(v) * _R.outdeg(v) > best))
+                {
+                    pivot = v;
+                    best = _G.outdeg(v) * _R.outdeg(v);
+                }
+
+            std::vector<vid> color(n, NIL);
+            std::vector<vid> fw, bw;
+            _reach(_G, {pivot}, active, color, fw);
+            for (auto v: fw)
+                color[v] = pivot;
+            std::vector<vid> roots(1, pivot);
+            std::vector<std::atomic<vid>> mark(n);
+            _collect(roots, active, color, mark, ans, next, bw);
+            left -= bw.size();
+            _detach(T, bw, work);
+            left -= _trim(T, work);
+        }
+
+        std::vector<std::atomic<vid>> color(n), mark(n);
+        while (left > serial_below)
+        {
+            // forward coloring: color[v] = largest active id that reaches v
+            parallel_for(0, n, [&](std::size_t v)
+            {
+                color[v].store(active[v] ? vid(v) : NIL, std::memory_order_relaxed);
+            });
+            std::atomic<bool> changed(true);
+            while (changed)
+            {
+                changed = false;
+                parallel_for(0, n, [&](std::size_t v)
+                {
+                    if (!active[v])
+                        return;
+                    vid c = color[v].load(std::memory_order_relaxed);
+                    for (auto w: _G.Adj(vid(v)))
+                    {
+                        if (!active[w])
+                            continue;
+                        vid cw = color[w].load(std::memory_order_relaxed);
+                        while (cw < c && !color[w].compare_exchange_weak(cw, c, std::memory_order_relaxed))
+                            ;
+                        if (cw < c)
+                            changed = true;
+                    }
+                }, 256);
+            }
+
+            std::vector<vid> roots, plain(n), found;
+            for (vid v = 0; v < n; ++v)
+            {
+                plain[v] = color[v].load(std::memory_order_relaxed);
+                if (active[v] && plain[v] == v)
+                    roots.push_back(v);
+            }
+            _collect(roots, active, plain, mark, ans, next, found);
+            left -= found.size();
+            _detach(T, found, work);
+            left -= _trim(T, work);
+        }
+
+        if (left > 0)
+        {
+            ans.count = next;
+            _pearce(active, ans);
+        }
+        else
+            ans.count = next;
+        return ans;
+    }
+
+private:
+
+    const csr_view & _G, & _R;
+
+    // pre: ans.comp is NIL exactly on the active vertices
+    // post: every active vertex is assigned a component numbered from
+    //       ans.count up, and ans.count is updated
+    void _pearce(const std::vector<char> & active, scc_result & ans) const
+    {
+        std::size_t n = _G.n();
+        std::vector<vid> rindex(n, 0);
+        std::vector<char> root(n, 0);
+        std::vector<vid> S;                                 // vertices waiting for their root
+        std::vector<std::pair<vid, std::size_t>> call;      // (vertex, next arc)
+        vid index = 1, c = vid(n ? n - 1 : 0);              // component c is named n-1-c
+
+        for (vid r = 0; r < n; ++r)
+        {
+            if (!active[r] || rindex[r] != 0)
+                continue;
+
+            root[r] = 1;
+            rindex[r] = index++;
+            call.push_back({r, _G.first(r)});
+
+            while (!call.empty())
+            {
+                vid v = call.back().first;
+                std::size_t & i = call.back().second;
+
+                if (i < _G.first(v+1))
+                {
+                    vid w = _G.target(i);
+                    if (!active[w])
+                    {
+                        ++i;
+                        continue;
+                    }
+                    if (rindex[w] == 0)       // tree arc: descend, revisit arc i on return
+                    {
+                        root[w] = 1;
+                        rindex[w] = index++;
+                        call.push_back({w, _G.first(w)});
+                        continue;
+                    }
+                    if (rindex[w] < rindex[v])
+                    {
+                        rindex[v] = rindex[w];
+                        root[v] = 0;
+                    }
+                    ++i;
+                    continue;
+                }
+
+                // all arcs of v are done
+                call.pop_back();
+                if (root[v])
+                {
+                    --index;
+                    while (!S.empty() && rindex[v] <= rindex[S.back()])
+                    {
+                        rindex[S.back()] = c;
+                        ans.comp[S.back()] = vid(ans.count);
+                        S.pop_back();
+                        --index;
+                    }
+                    rindex[v] = c--;
+                    ans.comp[v] = vid(ans.count++);
+                }
+                else
+                    S.push_back(v);
+
+                if (!call.empty())            // finish the tree arc into v
+                {
+                    vid u = call.back().first;
+                    if (rindex[v] < rindex[u])
+                    {
+                        rindex[u] = rindex[v];
+                        root[u] = 0;
+                    }
+                    ++call.back().second;
+                }
+            }
+        }
+    }
+
+    // the degree counters of parallel(), shared by _trim and _detach
+    struct trim_state
+    {
+        std::vector<char> & active;
+        std::vector<std::atomic<std::size_t>> & in, & out;
+        std::vector<std::atomic<char>> & queued;
+        scc_result & ans;
+        std::atomic<vid> & next;
+    };
+
+    // pre: work holds the queued vertices that are still active
+    // post: removes them and, round by round, every active vertex left
+    //       without active in- or out-arcs, each as its own component;
+    //       work is empty; returns how many.  Every vertex and arc is seen
+    //       at most once over all calls.
+    std::size_t _trim(trim_state & T, std::vector<vid> & work) const
+    {
+        std::size_t total = 0;
+        std::vector<vid> later;
+
+        while (!work.empty())
+        {
+            for (auto v: work)
+            {
+                T.active[v] = 0;
+                T.ans.comp[v] = T.next++;
+            }
+            total += work.size();
+            _detach(T, work, later);
+            work.swap(later);
+        }
+        return total;
+    }
+
+    // pre: the vertices of removed were just deactivated
+    // post: the counters of their active neighbours are decremented, and
+    //       the neighbours whose in- or out-count reached 0 are appended
+    //       to work
+    void _detach(trim_state & T, const std::vector<vid> & removed, std::vector<vid> & work) const
+    {
+        std::vector<std::vector<vid>> local(thread_pool::instance().size());
+
+        work.clear();
+        auto drop = [&](std::atomic<std::size_t> & c, vid w, std::size_t t)
+        {
+            char no = 0;
+            if (c.fetch_sub(1, std::memory_order_relaxed) == 1 &&
+                T.queued[w].compare_exchange_strong(no, 1, std::memory_order_relaxed))
+                local[t].push_back(w);
+        };
+        parallel_for_workers(0, removed.size(), [&](std::size_t k, std::size_t t)
+        {
+            vid v = removed[k];
+            for (auto w: _G.Adj(v))
+                if (w != v && T.active[w])
+                    drop(T.in[w], w, t);
+            for (auto w: _R.Adj(v))
+                if (w != v && T.active[w])
+                    drop(T.out[w], w, t);
+        }, 64);
+
+        for (auto & l: local)
+            work.insert(work.end(), l.begin(), l.end());
+    }
+
+    // post: out holds every active vertex reachable in D from the sources,
+    //       moving only between vertices of equal color
+    void _reach(const csr_view & D,
+                const std::vector<vid> & sources,
+                const std::vector<char> & active,
+                const std::vector<vid> & color,
+                std::vector<vid> & out) const
+    {
+        std::size_t n = D.n();
+        std::vector<std::atomic<char>> seen(n);
+        for (auto s: sources)
+            seen[s].store(1, std::memory_order_relaxed);
+
+        out = sources;
+        _levels(D, out, [&](vid v, vid w)
+        {
+            char no = 0;
+            return active[w] && color[w] == color[v] &&
+                   seen[w].load(std::memory_order_relaxed) == 0 &&
+                   seen[w].compare_exchange_strong(no, 1, std::memory_order_relaxed);
+        });
+    }
+
+    // post: for each root r, the active vertices of color color[r] that
+    //       reach r form a component; they are named, deactivated and
+    //       appended to found
+    void _collect(const std::vector<vid> & roots,
+                  std::vector<char> & active,
+                  const std::vector<vid> & color,
+                  std::vector<std::atomic<vid>> & mark,
+                  scc_result & ans,
+                  std::atomic<vid> & next,
+                  std::vector<vid> & found) const
+    {
+        for (vid v = 0; v < _G.n(); ++v)
+            mark[v].store(NIL, std::memory_order_relaxed);
+        for (auto r: roots)
+            mark[r].store(next++, std::memory_order_relaxed);
+
+        found = roots;
+        _levels(_R, found, [&](vid v, vid w)
+        {
+            vid none = NIL;
+            return active[w] && color[w] == color[v] &&
+                   mark[w].load(std::memory_order_relaxed) == NIL &&
+                   mark[w].compare_exchange_strong(none, mark[v].load(std::memory_order_relaxed),
+                                                   std::memory_order_relaxed);
+        });
+
+        for (auto v: found)
+        {
+            ans.comp[v] = mark[v].load(std::memory_order_relaxed);
+            active[v] = 0;
+        }
+    }
+
+    // pre: claim(v, w) returns true for exactly one v per newly reached w
+    // post: level-synchronous parallel search in D starting from the
+    //       vertices in order; every claimed vertex is appended to order
+    template <class Claim>
+    void _levels(const csr_view & D, std::vector<vid> & order, Claim claim) const
+    {
+        std::size_t workers = thread_pool::instance().size();
+        std::size_t head = 0;
+
+        while (head < order.size())
+        {
+            std::size_t tail = order.size();
+            std::vector<std::vector<vid>> local(workers);
+            std::atomic<std::size_t> cursor(head);
+
+            auto step = [&](std::size_t t)
+            {
+                for (;;)
+                {
+                    std::size_t lo = cursor.fetch_add(64);
+                    if (lo >= tail)
+                        return;
+                    for (std::size_t k = lo; k < std::min(tail, lo + 64); ++k)
+                        for (auto w: D.Adj(order[k]))
+                            if (claim(order[k], w))
+                                local[t].push_back(w);
+                }
+            };
+
+            if (tail - head <= 64 || workers == 1)
+                step(0);
+            else
+                thread_pool::instance().run(step);
+
+            for (auto & l: local)
+                order.insert(order.end(), l.begin(), l.end());
+            head = tail;
+        }
+    }
+};
+
+#endif /* scc_h */
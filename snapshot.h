@@ -0,0 +1,447 @@
+//
+//  snapshot.h
+//  Header file for a versioned binary snapshot of a digraph, network or
+//  flow network that can be memory-mapped and queried without parsing
+//
+
+#ifndef snapshot_h
+#define snapshot_h
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+#include "csr.h"
+#include "digraph.h"
+#include "network.h"
+#include "flownetwork.h"
+#include "io.h"
+#include "parallel.h"
+
+// File layout (native byte order; every section starts on an 8-byte
+// boundary and is zero-padded to one):
+//
+//     header            snapshot_header, 64 bytes
+//     offsets           n+1 uint64, csr offsets
+//     targets           m uint32, csr heads
+//     weights           m double, only if weighted
+//     vertex table      n values of T if T is arithmetic; for strings
+//                       n+1 uint64 offsets followed by the characters
+//     vertex index      n uint32, the ids in increasing order of vertex,
+//                       so index() is a binary search
+//
+// The checksum covers everything after the header: the payload is cut
+// into 1 MiB blocks, each block is hashed with 64-bit FNV-1a, and the
+// block hashes are hashed again in order, so blocks can be checked in
+// parallel.
+struct snapshot_header
+{
+    char magic[8];              // "AASNAP\0\0"
+    std::uint32_t version;      // snapshot::VERSION
+    std::uint32_t flags;        // snapshot::WEIGHTED | snapshot::FLOW
+    std::uint32_t vertex_kind;  // 0 string, 1 integer, 2 floating point
+    std::uint32_t vertex_size;  // sizeof(T) for numeric vertices
+    std::uint64_t n, m;
+    std::uint64_t vertex_bytes; // size of the vertex table
+    std::uint32_t source, sink; // flow networks only; NIL otherwise
+    std::uint64_t checksum;
+};
+
+static_assert(sizeof(snapshot_header) == 64, "snapshot header must be 64 bytes");
+static_assert(sizeof(std::size_t) == sizeof(std::uint64_t), "csr offsets are stored as uint64");
+
+
+// pre: none
+// post: returns the checksum of [b, b+len) as described above
+inline std::uint64_t snapshot_checksum(const char * b, std::size_t len)
+{
+    const std::size_t block = 1 << 20;
+    std::size_t blocks = (len + block - 1) / block;
+    std::vector<std::uint64_t> h(blocks);
+
+    auto fnv = [](const unsigned char * p, std::size_t k, std::uint64_t x)
+    {
+        for (std::size_t i = 0; i < k; ++i)
+        {
+            x ^= p[i];
+            x *= 1099511628211ull;
+        }
+        return x;
+    };
+
+    parallel_for(0, blocks, [&](std::size_t i)
+    {
+        std::size_t lo = i * block, hi = std::min(len, lo + block);
+        h[i] = fnv(reinterpret_cast<const unsigned char *>(b) + lo, hi - lo, 14695981039346656037ull);
+    }, 1);
+
+    return fnv(reinterpret_cast<const unsigned char *>(h.data()), h.size() * sizeof(std::uint64_t),
+               14695981039346656037ull);
+}
+
+
+// a snapshot file opened read-only by mmap; it is a csr_view, so the
+// engines run on it directly, and its vertices are read out of the
+// mapped vertex table on demand
+template <class T>
+class snapshot: public csr_view
+{
+public:
+
+    static const std::uint32_t VERSION = 2;
+    static const std::uint32_t WEIGHTED = 1;
+    static const std::uint32_t FLOW = 2;
+
+    snapshot(): _source(NIL), _sink(NIL), _names(nullptr), _chars(nullptr), _vertices(nullptr),
+        _order(nullptr)
+    {
+
+    }
+
+    // post: returns true iff the file at path is a snapshot with vertices
+    //       of type T whose sections fit its size; this snapshot then refers
+    //       to it until the next open(), and is unchanged otherwise.  That
+    //       much takes O(1) time.  If verify, the checksum must also match,
+    //       and every offset, target, vertex name and the vertex index are
+    //       checked, so a damaged file is rejected rather than read out of
+    //       range; without it the file is trusted past its header.
+    bool open(const std::string & path, bool verify = true)
+    {
+        std::unique_ptr<mapped_file> f(new mapped_file(path));
+        if (!f->isOpen() || f->size() < sizeof(snapshot_header))
+            return false;
+
+        snapshot_header h;
+        std::memcpy(&h, f->begin(), sizeof(h));
+        if (std::memcmp(h.magic, MAGIC, sizeof(h.magic)) != 0 || h.version != VERSION ||
+            h.vertex_kind != _kind() || (h.vertex_kind != 0 && h.vertex_size != sizeof(T)) ||
+            h.n >= NIL || (h.source != NIL && h.source >= h.n) || (h.sink != NIL && h.sink >= h.n))
+            return false;
+
+        // section sizes, each checked against the file before it is added
+        std::size_t off_bytes, adj_bytes, w_bytes = 0, order_bytes, size = f->size() - sizeof(h);
+        if (!_bytes(h.n + 1, 8, size, off_bytes) || !_bytes(h.m, 4, size, adj_bytes) ||
+            ((h.flags & WEIGHTED) && !_bytes(h.m, 8, size, w_bytes)) ||
+            !_bytes(h.n, 4, size, order_bytes) || h.vertex_bytes > size ||
+            size != off_bytes + adj_bytes + w_bytes + h.vertex_bytes + order_bytes)
+            return false;
+
+        const char * payload = f->begin() + sizeof(h);
+        if (verify && snapshot_checksum(payload, size) != h.checksum)
+            return false;
+
+        const char * p = payload;
+        const std::size_t * off = reinterpret_cast<const std::size_t *>(p);
+        const vid * adj = reinterpret_cast<const vid *>(p + off_bytes);
+        const double * w = (h.flags & WEIGHTED) ? reinterpret_cast<const double *>(p + off_bytes + adj_bytes)
+                                                : nullptr;
+        const char * vertices = p + off_bytes + adj_bytes + w_bytes;
+        const vid * order = reinterpret_cast<const vid *>(vertices + h.vertex_bytes);
+        if (!_bounds(h, off, vertices) || (verify && !_valid(h, off, adj, vertices, order)))
+            return false;
+
+        _n = h.n;
+        _off = off;
+        _adj = adj;
+        _w = w;
+        _vertices = vertices;
+        _names = reinterpret_cast<const std::uint64_t *>(vertices);
+        _chars = vertices + (h.n + 1) * 8;
+        _order = order;
+        _source = h.source;
+        _sink = h.sink;
+        _file = std::move(f);
+        return true;
+    }
+
+    bool isFlow() const
+    {
+        return (_source != NIL);
+    }
+
+    // pre: isFlow()
+    vid source() const
+    {
+        return _source;
+    }
+
+    vid sink() const
+    {
+        return _sink;
+    }
+
+    // pre: i < n()
+    // post: returns the vertex whose dense id is i
+    T vertex(vid i) const
+    {
+        assert(i < _n);
+        return _vertex(i, std::is_arithmetic<T>());
+    }
+
+    // pre: none
+    // post: returns true iff v is a vertex, by binary search of the vertex
+    //       index in the file
+    bool isVertex(const T & v) const
+    {
+        const vid * i = _find(v);
+        return (i != _order + _n && _compare(*i, v) == 0);
+    }
+
+    // pre: v is a vertex
+    // post: returns the dense id of v in O(log n) time; nothing is built,
+    //       so any number of threads may share the snapshot
+    vid index(const T & v) const
+    {
+        assert(isVertex(v));
+        return *_find(v);
+    }
+
+    // pre: G is the csr snapshot of a digraph or network; for a flow
+    //      network source and sink are its ids, otherwise NIL
+    // post: returns true iff G was written to the file at path
+    static bool save(const std::string & path, const csr<T> & G, vid source = NIL, vid sink = NIL)
+    {
+        snapshot_header h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, MAGIC, sizeof(h.magic));
+        h.version = VERSION;
+        h.flags = (G.m() != 0 && G.isWeighted() ? WEIGHTED : 0) | (source != NIL ? FLOW : 0);
+        h.vertex_kind = _kind();
+        h.vertex_size = std::is_arithmetic<T>::value ? sizeof(T) : 0;
+        h.n = G.n();
+        h.m = G.m();
+        h.source = source;
+        h.sink = sink;
+
+        std::vector<char> payload;
+        std::vector<std::uint64_t> off(G.n() + 1);
+        std::vector<vid> adj(G.m());
+        for (vid v = 0; v <= G.n(); ++v)
+            off[v] = G.first(v);
+        for (std::size_t i = 0; i < G.m(); ++i)
+            adj[i] = G.target(i);
+
+        _append(payload, off.data(), off.size() * 8);
+        _append(payload, adj.data(), adj.size() * 4);
+        if (h.flags & WEIGHTED)
+        {
+            std::vector<double> w(G.m());
+            for (std::size_t i = 0; i < G.m(); ++i)
+                w[i] = G.cost(i);
+            _append(payload, w.data(), w.size() * 8);
+        }
+
+        std::size_t table = payload.size();
+        _table(payload, G, std::is_arithmetic<T>());
+        h.vertex_bytes = payload.size() - table;
+
+        std::vector<vid> order(G.n());
+        for (vid i = 0; i < G.n(); ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](vid a, vid b) { return G.vertex(a) < G.vertex(b); });
+        _append(payload, order.data(), order.size() * 4);
+        h.checksum = snapshot_checksum(payload.data(), payload.size());
+
+        std::FILE * f = std::fopen(path.c_str(), "wb");
+        if (f == nullptr)
+            return false;
+        bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+                  std::fwrite(payload.data(), 1, payload.size(), f) == payload.size();
+        return (std::fclose(f) == 0 && ok);
+    }
+
+private:
+
+    static constexpr const char * MAGIC = "AASNAP\0\0";
+
+    std::unique_ptr<mapped_file> _file;
+    vid _source, _sink;
+    const std::uint64_t * _names;       // string vertices: offsets into _chars
+    const char * _chars;
+    const char * _vertices;             // numeric vertices
+    const vid * _order;                 // ids in increasing order of vertex
+
+    static std::uint32_t _kind()
+    {
+        return std::is_integral<T>::value ? 1 : std::is_floating_point<T>::value ? 2 : 0;
+    }
+
+    static std::size_t _pad(std::size_t k)
+    {
+        return (k + 7) / 8 * 8;
+    }
+
+    // post: returns true iff k items of the given size, padded to 8 bytes,
+    //       fit in limit bytes without overflow; bytes is then their size
+    static bool _bytes(std::uint64_t k, std::size_t size, std::size_t limit, std::size_t & bytes)
+    {
+        if (k > limit / size)
+            return false;
+        bytes = _pad(k * size);
+        return (bytes <= limit);
+    }
+
+    // pre: the sections of h fit in the file
+    // post: returns true iff the ends of the offsets and of the vertex
+    //       table are what h says; O(1) time
+    static bool _bounds(const snapshot_header & h, const std::size_t * off, const char * vertices)
+    {
+        if (off[0] != 0 || off[h.n] != h.m)
+            return false;
+        if (h.vertex_kind != 0)
+            return (h.vertex_bytes == _pad(h.n * sizeof(T)));
+
+        std::size_t chars;
+        if (!_bytes(h.n + 1, 8, h.vertex_bytes, chars))
+            return false;
+        const std::uint64_t * names = reinterpret_cast<const std::uint64_t *>(vertices);
+        return (names[0] == 0 && names[h.n] <= h.vertex_bytes - chars);
+    }
+
+    // pre: _bounds(h, off, vertices)
+    // post: returns true iff the offsets do not decrease, every target is
+    //       below h.n, the string offsets do not decrease, and order lists
+    //       every id once in strictly increasing order of vertex
+    static bool _valid(const snapshot_header & h, const std::size_t * off, const vid * adj,
+                       const char * vertices, const vid * order)
+    {
+        std::atomic<bool> ok(true);
+        parallel_for(0, h.n, [&](std::size_t v)
+        {
+            if (off[v] > off[v+1])
+                ok = false;
+        }, 4096);
+        parallel_for(0, ok ? h.m : 0, [&](std::size_t i)
+        {
+            if (adj[i] >= h.n)
+                ok = false;
+        }, 1 << 16);
+        if (!ok)
+            return false;
+
+        const std::uint64_t * names = reinterpret_cast<const std::uint64_t *>(vertices);
+        if (h.vertex_kind == 0)
+            for (std::size_t v = 0; v < h.n; ++v)
+                if (names[v] > names[v+1])
+                    return false;
+
+        std::vector<char> seen(h.n, 0);
+        for (std::size_t k = 0; k < h.n; ++k)
+        {
+            if (order[k] >= h.n || seen[order[k]])
+                return false;
+            seen[order[k]] = 1;
+        }
+        const char * chars = vertices + (h.n + 1) * 8;
+        for (std::size_t k = 1; k < h.n; ++k)
+            if (!(_read(vertices, names, chars, order[k-1], std::is_arithmetic<T>()) <
+                  _read(vertices, names, chars, order[k], std::is_arithmetic<T>())))
+                return false;
+        return true;
+    }
+
+    // post: appends len bytes at p to out, zero-padded to a multiple of 8
+    static void _append(std::vector<char> & out, const void * p, std::size_t len)
+    {
+        const char * c = static_cast<const char *>(p);
+        out.insert(out.end(), c, c + len);
+        out.resize(_pad(out.size()), 0);
+    }
+
+    static void _table(std::vector<char> & out, const csr<T> & G, std::true_type)
+    {
+        std::vector<T> v(G.n());
+        for (vid i = 0; i < G.n(); ++i)
+            v[i] = G.vertex(i);
+        _append(out, v.data(), v.size() * sizeof(T));
+    }
+
+    static void _table(std::vector<char> & out, const csr<T> & G, std::false_type)
+    {
+        std::vector<std::uint64_t> off(G.n() + 1, 0);
+        std::string chars;
+        for (vid i = 0; i < G.n(); ++i)
+        {
+            chars += G.vertex(i);
+            off[i+1] = chars.size();
+        }
+        _append(out, off.data(), off.size() * 8);
+        _append(out, chars.data(), chars.size());
+    }
+
+    T _vertex(vid i, std::true_type) const
+    {
+        return _read(_vertices, _names, _chars, i, std::true_type());
+    }
+
+    T _vertex(vid i, std::false_type) const
+    {
+        return _read(_vertices, _names, _chars, i, std::false_type());
+    }
+
+    static T _read(const char * vertices, const std::uint64_t *, const char *, vid i, std::true_type)
+    {
+        T x;
+        std::memcpy(&x, vertices + i * sizeof(T), sizeof(T));
+        return x;
+    }
+
+    static T _read(const char *, const std::uint64_t * names, const char * chars, vid i, std::false_type)
+    {
+        return T(chars + names[i], chars + names[i+1]);
+    }
+
+    // post: returns <0, 0 or >0 as vertex(i) is less than, equal to or
+    //       greater than v
+    int _compare(vid i, const T & v) const
+    {
+        return _compare(i, v, std::is_arithmetic<T>());
+    }
+
+    int _compare(vid i, const T & v, std::true_type) const
+    {
+        T x = _vertex(i, std::true_type());
+        return (x < v) ? -1 : (v < x) ? 1 : 0;
+    }
+
+    int _compare(vid i, const T & v, std::false_type) const
+    {
+        int c = v.compare(0, v.size(), _chars + _names[i], _names[i+1] - _names[i]);
+        return (c < 0) ? 1 : (c > 0) ? -1 : 0;
+    }
+
+    // post: returns the first entry of the vertex index not less than v
+    const vid * _find(const T & v) const
+    {
+        return std::lower_bound(_order, _order + _n, v,
+                                [&](vid i, const T & x) { return _compare(i, x) < 0; });
+    }
+};
+
+
+// post: returns true iff D was written to the file at path as a snapshot
+template <class T>
+bool save(const std::string & path, const digraph<T> & D)
+{
+    return snapshot<T>::save(path, D.freeze());
+}
+
+template <class T>
+bool save(const std::string & path, const network<T> & N)
+{
+    return snapshot<T>::save(path, N.freeze());
+}
+
+template <class T>
+bool save(const std::string & path, const flow_network<T> & N)
+{
+    csr<T> G = N.freeze();
+    return snapshot<T>::save(path, G, G.index(N.source()), G.index(N.sink()));
+}
+
+#endif /* snapshot_h */
@@ -0,0 +1,365 @@
+//
+//  sssp.h
+//  Header file for single-source shortest paths on dense vertex ids
+//
+
+#ifndef sssp_h
+#define sssp_h
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include "csr.h"
+#include "dary_heap.h"
+#include "radix_heap.h"
+#include "parallel.h"
+
+// Dijkstra's algorithm on a weighted csr snapshot with non-negative
+// weights.  Distances and parents live in arrays indexed by vertex id, and
+// the fringe is an indexed_heap, so a relaxation touches no hash table.
+// The engine remembers which vertices a search reached and resets only
+// those before the next search; after the first search it allocates
+// nothing, which makes one engine per thread cheap for batches of queries.
+//
+// When every weight is a small non-negative integer the fringe is a
+// monotone integer queue instead: Dial's buckets if the largest weight is
+// at most DIAL_MAX, a radix heap otherwise.  Those keep stale entries
+// rather than decreasing keys, and the search skips them.
+class sssp_engine
+{
+public:
+
+    enum queue_kind { AUTO, HEAP, DIAL, RADIX };
+
+    static constexpr std::uint64_t DIAL_MAX = 1 << 12;
+
+    // a kind of fringe with the largest weight of the snapshot it is for,
+    // or -1 if some weight is not a non-negative integer; DIAL sizes its
+    // buckets by that weight, so an engine made from a fringe that was
+    // chosen once does not scan the arcs again
+    struct fringe
+    {
+        queue_kind kind;
+        double c;
+
+        explicit fringe(queue_kind k = HEAP, double w = -1): kind(k), c(w)
+        {
+
+        }
+    };
+
+    // pre: G is weighted, has no negative weights and outlives the engine;
+    //      q is the kind of fringe, chosen by choose(G) if AUTO, and d is
+    //      the arity of the heap.  AUTO and DIAL scan the weights once.
+    sssp_engine(const csr_view & G, queue_kind q = AUTO, std::size_t d = 4):
+        sssp_engine(G, choose(G, q), d)
+    {
+
+    }
+
+    // pre: as above; f is choose(G, q) for some q, and f.c >= 0 if f.kind
+    //      is DIAL
+    sssp_engine(const csr_view & G, fringe f, std::size_t d = 4): _G(G), _source(NIL),
+        _dist(G.n(), std::numeric_limits<double>::infinity()), _parent(G.n(), NIL),
+        _kind(f.kind), _H(_kind == HEAP ? G.n() : 0, d),
+        _dial(_kind == DIAL && f.c >= 0 ? std::uint64_t(f.c) : 0), _goals(0)
+    {
+        assert(f.kind != AUTO && (f.kind != DIAL || f.c >= 0));
+    }
+
+    // pre: G is weighted
+    // post: for AUTO, returns DIAL if every weight is an integer in
+    //       [0, DIAL_MAX], RADIX if every weight is a non-negative integer
+    //       and every path length is exact in a double, and HEAP otherwise;
+    //       any other q is returned as it is.  Only AUTO and DIAL scan the
+    //       weights, and the largest is returned with the kind.
+    static fringe choose(const csr_view & G, queue_kind q = AUTO)
+    {
+        if (q != AUTO && q != DIAL)
+            return fringe(q);
+
+        double c = _max_weight(G);
+        if (q == DIAL || c < 0)
+            return fringe(q == DIAL ? DIAL : HEAP, c);
+        if (c <= DIAL_MAX)
+            return fringe(DIAL, c);
+        return fringe((c * double(G.n()) < 9007199254740992.0) ? RADIX : HEAP, c);   // 2^53
+    }
+
+    queue_kind kind() const
+    {
+        return _kind;
+    }
+
+    // pre: s < G.n(); t < G.n() or t == NIL
+    // post: if t == NIL, dist(v) is the distance from s to every v; otherwise
+    //       the search stopped as soon as t was settled, and dist(v) is
+    //       exact for t and for every vertex settled before it.  In both
+    //       cases parent(v) gives the shortest path tree of those vertices.
+    void run(vid s, vid t = NIL)
+    {
+        assert(s < _G.n() && (t == NIL || t < _G.n()));
+        _goals = 0;
+        _run(s, t);
+    }
+
+    // pre: s < G.n() and every target is < G.n()
+    // post: same as run(s, t), but the search stops once every target has
+    //       been settled
+    void run(vid s, const std::vector<vid> & targets)
+    {
+        assert(s < _G.n());
+        if (_goal.size() != _G.n())
+            _goal.assign(_G.n(), 0);
+
+        _goals = 0;
+        for (auto t: targets)
+            if (!_goal[t])
+            {
+                _goal[t] = 1;
+                ++_goals;
+            }
+
+        if (_goals == 0)
+            reset();
+        else
+            _run(s, NIL);
+
+        for (auto t: targets)
+            _goal[t] = 0;
+        _goals = 0;
+    }
+
+    // post: forgets the last search in time proportional to the number of
+    //       vertices it reached
+    void reset()
+    {
+        for (auto v: _touched)
+        {
+            _dist[v] = std::numeric_limits<double>::infinity();
+            _parent[v] = NIL;
+        }
+        _touched.clear();
+        _source = NIL;
+    }
+
+    // pre: v < G.n()
+    // post: returns the distance found to v, or infinity if v was not reached
+    double dist(vid v) const
+    {
+        return _dist[v];
+    }
+
+    // post: returns the vertex before v on the path found to v; the source
+    //       is its own parent and unreached vertices have parent NIL
+    vid parent(vid v) const
+    {
+        return _parent[v];
+    }
+
+    bool reached(vid v) const
+    {
+        return (_parent[v] != NIL);
+    }
+
+    const std::vector<double> & dists() const
+    {
+        return _dist;
+    }
+
+    const std::vector<vid> & parents() const
+    {
+        return _parent;
+    }
+
+    // post: returns the vertices reached by the last search
+    const std::vector<vid> & touched() const
+    {
+        return _touched;
+    }
+
+    // pre: t was settled by the last search
+    // post: returns the ids on the path found from the source to t, or an
+    //       empty vector if t was not reached
+    std::vector<vid> path(vid t) const
+    {
+        std::vector<vid> ans;
+        if (!reached(t))
+            return ans;
+
+        for (vid v = t; v != _source; v = _parent[v])
+            ans.push_back(v);
+        ans.push_back(_source);
+        std::reverse(ans.begin(), ans.end());
+        return ans;
+    }
+
+private:
+
+    const csr_view & _G;
+    vid _source;
+    std::vector<double> _dist;
+    std::vector<vid> _parent;
+    std::vector<vid> _touched;      // vertices reached by the last search
+    queue_kind _kind;
+    indexed_heap<double> _H;        // fringe, by tentative distance, for HEAP
+    bucket_queue _dial;             // the same for DIAL
+    radix_heap _radix;              // and for RADIX
+    std::vector<unsigned char> _goal;   // targets of run(s, targets)
+    std::size_t _goals;                 // targets not settled yet
+
+    // post: returns the largest weight of G, or -1 if some weight is not a
+    //       non-negative integer
+    static double _max_weight(const csr_view & G)
+    {
+        std::vector<double> most(thread_pool::instance().size(), 0);
+
+        thread_pool::instance().run([&](std::size_t t)
+        {
+            std::size_t k = most.size();
+            for (std::size_t i = G.m() * t / k; i < G.m() * (t + 1) / k; ++i)
+            {
+                double w = G.cost(i);
+                if (!(w >= 0 && w == std::floor(w)))
+                {
+                    most[t] = -1;
+                    return;
+                }
+                most[t] = std::max(most[t], w);
+            }
+        });
+
+        double c = 0;
+        for (auto x: most)
+            if (x < 0)
+                return -1;
+            else
+                c = std::max(c, x);
+        return c;
+    }
+
+    void _run(vid s, vid t)
+    {
+        reset();
+
+        _source = s;
+        _touched.push_back(s);
+        _dist[s] = 0;
+        _parent[s] = s;
+
+        if (_kind == DIAL)
+            _search(_dial, s, t);
+        else if (_kind == RADIX)
+            _search(_radix, s, t);
+        else
+            _search(_H, s, t);
+    }
+
+    // the same loop for every kind of fringe; a popped entry whose key is
+    // larger than the distance of its vertex is stale and skipped
+    template <class Queue>
+    void _search(Queue & Q, vid s, vid t)
+    {
+        double k;
+        vid v;
+
+        _push(Q, s, 0);
+        while (_pop(Q, k, v))
+        {
+            if (k > _dist[v])
+                continue;
+            if (v == t || (_goals > 0 && _goal[v] && --_goals == 0))
+                break;
+
+            for (std::size_t i = _G.first(v); i < _G.first(v+1); ++i)
+            {
+                vid w = _G.target(i);
+                double temp = k + _G.cost(i);
+                if (temp < _dist[w])    // found better route
+                {
+                    if (_parent[w] == NIL)
+                        _touched.push_back(w);
+                    _dist[w] = temp;
+                    _parent[w] = v;
+                    _push(Q, w, temp);
+                }
+            }
+        }
+        Q.clear();
+    }
+
+    static void _push(indexed_heap<double> & Q, vid v, double k)
+    {
+        Q.push_or_decrease(v, k);
+    }
+
+    static bool _pop(indexed_heap<double> & Q, double & k, vid & v)
+    {
+        if (Q.empty())
+            return false;
+        k = Q.min_key();
+        v = vid(Q.min());
+        Q.pop_min();
+        return true;
+    }
+
+    template <class Queue>
+    static void _push(Queue & Q, vid v, double k)
+    {
+        Q.push(std::uint64_t(k), v);
+    }
+
+    template <class Queue>
+    static bool _pop(Queue & Q, double & k, vid & v)
+    {
+        std::uint64_t key;
+        if (!Q.pop(key, v))
+            return false;
+        k = double(key);
+        return true;
+    }
+};
+
+
+
+// pre: G is weighted with no negative weights, every source and target is
+//      < G.n(), and out has room for sources.size() * targets.size() values
+// post: out[i * targets.size() + j] is the distance from sources[i] to
+//       targets[j], or infinity if there is none.  Sources are spread over
+//       the workers of the thread pool; each worker makes one engine with
+//       fringe q (see sssp_engine::choose) and reuses it for all its
+//       searches, which stop once every target is settled.
+inline void distance_matrix(const csr_view & G,
+                            const std::vector<vid> & sources,
+                            const std::vector<vid> & targets,
+                            double * out,
+                            sssp_engine::fringe q)
+{
+    std::vector<std::unique_ptr<sssp_engine>> E(thread_pool::instance().size());
+    parallel_for_workers(0, sources.size(), [&](std::size_t i, std::size_t t)
+    {
+        if (!E[t])
+            E[t].reset(new sssp_engine(G, q));
+        E[t]->run(sources[i], targets);
+
+        double * row = out + i * targets.size();
+        for (std::size_t j = 0; j < targets.size(); ++j)
+            row[j] = E[t]->dist(targets[j]);
+    }, 1);
+}
+
+// post: same as above, with the fringe chosen by sssp_engine::choose(G, q)
+inline void distance_matrix(const csr_view & G,
+                            const std::vector<vid> & sources,
+                            const std::vector<vid> & targets,
+                            double * out,
+                            sssp_engine::queue_kind q = sssp_engine::AUTO)
+{
+    distance_matrix(G, sources, targets, out, sssp_engine::choose(G, q));
+}
+
+#endif /* sssp_h */
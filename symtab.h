@@ -0,0 +1,98 @@
+//
+//  symtab.h
+//  Header file for a symbol table that interns vertex names to dense ids
+//
+
+#ifndef symtab_h
+#define symtab_h
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cassert>
+#include <limits>
+
+#ifndef DENSE_VERTEX_ID
+#define DENSE_VERTEX_ID
+
+typedef std::uint32_t vid;                              // dense vertex id
+const vid NIL = std::numeric_limits<vid>::max();        // "no vertex"
+
+#endif
+
+// maps each distinct name to an id 0, 1, 2, ... in order of first appearance;
+// names are hashed once, when they are interned, and never again by callers
+// that keep the ids
+template <class Name>
+class symtab
+{
+public:
+
+    symtab()
+    {
+
+    }
+
+    // pre: none
+    // post: returns the number of interned names
+    std::size_t size() const
+    {
+        return _names.size();
+    }
+
+    void reserve(std::size_t n)
+    {
+        _names.reserve(n);
+        _id.reserve(n);
+    }
+
+    // pre: none
+    // post: returns true iff x has been interned
+    bool contains(const Name & x) const
+    {
+        return (_id.count(x) != 0);
+    }
+
+    // pre: none
+    // post: returns the id of x, or NIL if x has not been interned
+    vid find(const Name & x) const
+    {
+        auto it = _id.find(x);
+        return (it == _id.end() ? NIL : it->second);
+    }
+
+    // pre: none
+    // post: returns the id of x, interning x first if necessary
+    vid intern(const Name & x)
+    {
+        auto ins = _id.emplace(x, vid(_names.size()));
+        if (ins.second)
+        {
+            assert(_names.size() < NIL);
+            _names.push_back(x);
+        }
+        return ins.first->second;
+    }
+
+    // pre: i < size()
+    // post: returns the name whose id is i
+    const Name & name(vid i) const
+    {
+        assert(i < _names.size());
+        return _names[i];
+    }
+
+    // pre: none
+    // post: returns all names in id order; _names()[i] is the name with id i
+    const std::vector<Name> & names() const
+    {
+        return _names;
+    }
+
+private:
+
+    std::vector<Name> _names;               // _names[i] is the name with id i
+    std::unordered_map<Name, vid> _id;      // _names[_id[x]] = x
+};
+
+#endif /* symtab_h */
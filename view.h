@@ -0,0 +1,181 @@
+//
+//  view.h
+//  Header file for non-owning range views over vertices and neighbors
+//
+
+#ifndef view_h
+#define view_h
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+// a half-open range [b, e) that can be used in range-based for loops;
+// it does not own the elements, so it is invalidated by any change to the
+// container it was taken from
+template <class It>
+class range
+{
+public:
+
+    range(It b = It(), It e = It()): _b(b), _e(e)
+    {
+
+    }
+
+    It begin() const
+    {
+        return _b;
+    }
+
+    It end() const
+    {
+        return _e;
+    }
+
+    std::size_t size() const
+    {
+        return std::distance(_b, _e);
+    }
+
+    bool empty() const
+    {
+        return (_b == _e);
+    }
+
+private:
+    It _b, _e;
+};
+
+
+// iterator over a map that yields only the keys
+template <class MapIt>
+class key_iterator
+{
+public:
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename std::remove_const<typename std::iterator_traits<MapIt>::value_type::first_type>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type * pointer;
+    typedef const value_type & reference;
+
+    key_iterator(MapIt it = MapIt()): _it(it)
+    {
+
+    }
+
+    reference operator * () const
+    {
+        return _it->first;
+    }
+
+    pointer operator -> () const
+    {
+        return &(_it->first);
+    }
+
+    key_iterator & operator ++ ()
+    {
+        ++_it;
+        return *this;
+    }
+
+    key_iterator operator ++ (int)
+    {
+        key_iterator old(*this);
+        ++_it;
+        return old;
+    }
+
+    bool operator == (const key_iterator & other) const
+    {
+        return (_it == other._it);
+    }
+
+    bool operator != (const key_iterator & other) const
+    {
+        return (_it != other._it);
+    }
+
+private:
+    MapIt _it;
+};
+
+
+// iterator over dense ids that yields the name of each id,
+// where the name of id i is names[i]
+template <class IdIt, class Name>
+class name_iterator
+{
+public:
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Name value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Name * pointer;
+    typedef const Name & reference;
+
+    name_iterator(IdIt it = IdIt(), const std::vector<Name> * names = nullptr): _it(it), _names(names)
+    {
+
+    }
+
+    reference operator * () const
+    {
+        return (*_names)[*_it];
+    }
+
+    pointer operator -> () const
+    {
+        return &(*_names)[*_it];
+    }
+
+    name_iterator & operator ++ ()
+    {
+        ++_it;
+        return *this;
+    }
+
+    name_iterator operator ++ (int)
+    {
+        name_iterator old(*this);
+        ++_it;
+        return old;
+    }
+
+    bool operator == (const name_iterator & other) const
+    {
+        return (_it == other._it);
+    }
+
+    bool operator != (const name_iterator & other) const
+    {
+        return (_it != other._it);
+    }
+
+private:
+    IdIt _it;
+    const std::vector<Name> * _names;
+};
+
+
+// post: returns a view of the keys of map M
+template <class Map>
+range<key_iterator<typename Map::const_iterator>> keys(const Map & M)
+{
+    typedef key_iterator<typename Map::const_iterator> It;
+    return range<It>(It(M.begin()), It(M.end()));
+}
+
+// post: returns a view of the names of the ids in C
+template <class Container, class Name>
+range<name_iterator<typename Container::const_iterator, Name>> names(const Container & C,
+                                                                     const std::vector<Name> & names)
+{
+    typedef name_iterator<typename Container::const_iterator, Name> It;
+    return range<It>(It(C.begin(), &names), It(C.end(), &names));
+}
+
+#endif /* view_h */
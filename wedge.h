@@ -50,9 +50,10 @@ namespace std
     template <class T>
     class hash<WEdge<T>>
     {
+    public:
         std::size_t operator() (const WEdge<T> & e) const
         {
-            return std::hash<Edge<T>>() (e) ^
+            return std::hash<Edge<T>>() (Edge<T>(e.s, e.d)) * 31 +
                     std::hash<double>() (e.w);
         }
     };